@@ -0,0 +1,159 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "format.h"
+#include "linux_parser.h"
+#include "proc_fixture.h"
+#include "process.h"
+#include "process_table.h"
+#include "sample.h"
+#include "self_stats.h"
+#include "system_snapshot.h"
+#include "worker_pool.h"
+
+/*
+Per tick latency and allocations of every stage of the monitor over
+synthetic proc trees of 1k, 10k and 100k PIDs
+Usage: monitor_bench [ticks] [pid counts...]
+*/
+
+namespace {
+const int kCores{8};
+const size_t kRows{10};
+const size_t kChunk{32};
+// PID stat files rewritten per tick, one in kStride, so the processes
+// have different cpu usages to sort without rewriting 100k files
+const int kStride{8};
+
+enum Stage { kDiscovery = 0, kParse, kSort, kFormat, kStages };
+const char* const kStageNames[kStages] = {"discovery", "parse", "sort",
+                                          "format"};
+
+struct Measure {
+  std::vector<double> milliseconds[kStages];
+  std::vector<unsigned long> allocations[kStages];
+};
+
+// formats the rows the way the display does
+size_t FormatRows(std::vector<Process>& top, std::vector<ProcessSample>& rows) {
+  size_t characters = 0;
+  rows.resize(top.size());
+  for (size_t i = 0; i < top.size(); ++i) {
+    rows[i].pid = top[i].Pid();
+    rows[i].user = top[i].User();
+    rows[i].command = top[i].Command();
+    rows[i].cpu_utilization = top[i].CpuUtilization();
+    rows[i].ram_kb = top[i].RamKb();
+    rows[i].uptime = top[i].UpTime();
+    characters += std::to_string(rows[i].pid).size();
+    characters += std::to_string(rows[i].cpu_utilization * 100).size();
+    characters += Format::ElapsedTime(rows[i].uptime).size();
+  }
+  return characters;
+}
+
+double Median(std::vector<double> values) {
+  std::nth_element(values.begin(), values.begin() + values.size() / 2,
+                   values.end());
+  return values[values.size() / 2];
+}
+
+void Run(int pids, int ticks, unsigned int threads) {
+  std::string directory = "/tmp/monitor_bench_" + std::to_string(pids);
+  if (!ProcFixture::Generate(directory, pids, kCores)) {
+    std::perror(directory.c_str());
+    return;
+  }
+  if (!LinuxParser::ProcDirectory(directory)) {
+    std::perror(directory.c_str());
+    return;
+  }
+
+  ProcessTable table;
+  WorkerPool pool(threads);
+  std::vector<Process> top;
+  std::vector<ProcessSample> rows;
+  Measure measure;
+  volatile size_t sink = 0;
+  // the first tick sees every PID born, it is not measured
+  for (int tick = -1; tick < ticks; ++tick) {
+    ProcFixture::Tick(directory, pids, kCores, tick + 1, kStride);
+    auto stage_start = std::chrono::steady_clock::now();
+    unsigned long stage_allocations = SelfStats::Totals().allocations;
+    auto finish = [&](Stage stage) {
+      auto now = std::chrono::steady_clock::now();
+      if (tick >= 0) {
+        measure.milliseconds[stage].push_back(
+            std::chrono::duration<double, std::milli>(now - stage_start)
+                .count());
+        measure.allocations[stage].push_back(SelfStats::Totals().allocations -
+                                            stage_allocations);
+      }
+      stage_start = std::chrono::steady_clock::now();
+      stage_allocations = SelfStats::Totals().allocations;
+    };
+
+    table.Update(LinuxParser::Pids());
+    finish(kDiscovery);
+
+    // the fields are fetched the way System does
+    SystemSnapshot snapshot = SystemSnapshot::Capture();
+    std::vector<Process>& processes = table.Processes();
+    unsigned int fields = Process::Fields(SortKey::kCpu);
+    unsigned int stamp = tick + 2;
+    pool.ParallelFor(processes.size(), kChunk,
+                     [&](size_t begin, size_t end) {
+                       for (size_t i = begin; i < end; ++i) {
+                         processes[i].Fetch(fields, snapshot, stamp);
+                       }
+                     });
+    finish(kParse);
+
+    table.Top(kRows, SortKey::kCpu,
+              [&](Process& process) {
+                process.Fetch(kDisplayFields, snapshot, stamp);
+              },
+              top);
+    finish(kSort);
+
+    sink = sink + FormatRows(top, rows);
+    finish(kFormat);
+  }
+
+  std::printf("%8d PIDs, %u threads\n", pids, threads);
+  for (int stage = 0; stage < kStages; ++stage) {
+    std::vector<double> allocated(measure.allocations[stage].begin(),
+                                  measure.allocations[stage].end());
+    std::printf("  %-10s %10.3f ms %12.0f allocations\n", kStageNames[stage],
+                Median(measure.milliseconds[stage]), Median(allocated));
+  }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int ticks = argc > 1 ? std::stoi(argv[1]) : 5;
+  // the medians need a measured tick
+  if (ticks < 1) {
+    std::fprintf(stderr, "usage: %s [ticks >= 1] [pid counts...]\n", argv[0]);
+    return 1;
+  }
+  std::vector<int> counts;
+  for (int i = 2; i < argc; ++i) {
+    counts.push_back(std::stoi(argv[i]));
+  }
+  if (counts.empty()) {
+    counts = {1000, 10000, 100000};
+  }
+  unsigned int threads =
+      std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+  std::printf("median per tick over %d ticks\n", ticks);
+  for (int pids : counts) {
+    Run(pids, ticks, threads);
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+/*
+Parsing microbenchmark, compares the previous iostream based parsing
+of LinuxParser with the ProcReader layer on the same /proc files and
+reports the number of bytes parsed per second for each of them
+Usage: parse_bench [seconds per case]
+*/
+
+namespace Legacy {
+// iostream based implementations as they were in LinuxParser
+long ActiveJiffies(int pid) {
+  long active_jiffies = 0;
+  std::ifstream stream("/proc/" + std::to_string(pid) + "/stat");
+  if (stream.is_open()) {
+    std::string line;
+    std::getline(stream, line);
+    std::istringstream line_stream(line);
+    for (int i = 0; i < 13; ++i) {
+      line_stream.ignore(256, ' ');
+    }
+    long utime, stime, cutime, cstime;
+    line_stream >> utime >> stime >> cutime >> cstime;
+    active_jiffies = utime + stime + cutime + cstime;
+  }
+  return active_jiffies;
+}
+
+long CpuJiffies() {
+  long total = 0;
+  std::ifstream stream("/proc/stat");
+  if (stream.is_open()) {
+    std::string line, temp;
+    std::getline(stream, line);
+    std::istringstream line_stream(line);
+    line_stream >> temp;
+    for (int i = 0; i < 10; ++i) {
+      line_stream >> temp;
+      total += std::stol(temp);
+    }
+  }
+  return total;
+}
+
+float MemoryUtilization() {
+  float memory_utilized = 0.0;
+  std::ifstream stream("/proc/meminfo");
+  if (stream.is_open()) {
+    std::string line, temp;
+    std::getline(stream, line);
+    std::istringstream total_mem_line_stream(line);
+    float total_memory, free_memory;
+    total_mem_line_stream >> temp >> total_memory;
+    std::getline(stream, line);
+    std::istringstream free_mem_line_stream(line);
+    free_mem_line_stream >> temp >> free_memory;
+    memory_utilized = (total_memory - free_memory) / total_memory;
+  }
+  return memory_utilized;
+}
+
+// parse an in-memory stat line, isolates user space parsing from syscalls
+long ParseStat(const std::string& line) {
+  std::istringstream line_stream(line);
+  for (int i = 0; i < 13; ++i) {
+    line_stream.ignore(256, ' ');
+  }
+  long utime, stime, cutime, cstime;
+  line_stream >> utime >> stime >> cutime >> cstime;
+  return utime + stime + cutime + cstime;
+}
+}  // namespace Legacy
+
+namespace {
+// size of the file as read by one parse
+size_t FileSize(const char* path) {
+  std::ifstream stream(path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(stream)),
+                      std::istreambuf_iterator<char>());
+  return content.size();
+}
+
+double BytesPerSecond(const std::function<long()>& parse, size_t file_size,
+                      double seconds) {
+  using clock = std::chrono::steady_clock;
+  volatile long sink = 0;
+  long iterations = 0;
+  auto start = clock::now();
+  auto deadline = start + std::chrono::duration<double>(seconds);
+  while (clock::now() < deadline) {
+    for (int i = 0; i < 64; ++i) {
+      sink = sink + parse();
+    }
+    iterations += 64;
+  }
+  std::chrono::duration<double> elapsed = clock::now() - start;
+  return iterations * double(file_size) / elapsed.count();
+}
+
+void Report(const char* name, const char* path,
+            const std::function<long()>& before,
+            const std::function<long()>& after, double seconds) {
+  size_t size = FileSize(path);
+  double before_rate = BytesPerSecond(before, size, seconds);
+  double after_rate = BytesPerSecond(after, size, seconds);
+  std::printf("%-20s %10.1f MB/s %10.1f MB/s %8.2fx\n", name,
+              before_rate / 1e6, after_rate / 1e6, after_rate / before_rate);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  double seconds = argc > 1 ? std::stod(argv[1]) : 1.0;
+  int pid = getpid();
+  std::printf("%-20s %15s %15s %9s\n", "case", "iostream", "ProcReader",
+              "speedup");
+  Report("pid stat", "/proc/self/stat",
+         [pid] { return Legacy::ActiveJiffies(pid); },
+         [pid] { return LinuxParser::ActiveJiffies(pid); }, seconds);
+  Report("cpu line", "/proc/stat", [] { return Legacy::CpuJiffies(); },
+         [] { return LinuxParser::Jiffies(); }, seconds);
+  Report("meminfo", "/proc/meminfo",
+         [] { return long(Legacy::MemoryUtilization() * 1000); },
+         [] { return long(LinuxParser::MemoryUtilization() * 1000); },
+         seconds);
+
+  // user space parsing only, the stat line is read once up front
+  std::ifstream stream("/proc/self/stat");
+  std::string line;
+  std::getline(stream, line);
+  Report("pid stat (parse)", "/proc/self/stat",
+         [&line] { return Legacy::ParseStat(line); },
+         [&line] {
+           ProcReader::PidStat stat;
+           ProcReader::ParsePidStat(line, stat);
+           return stat.utime + stat.stime + stat.cutime + stat.cstime;
+         },
+         seconds);
+  return 0;
+}
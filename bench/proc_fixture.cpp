@@ -0,0 +1,158 @@
+#include <sys/stat.h>
+#include <cstdio>
+#include <string>
+
+#include "proc_fixture.h"
+
+using std::string;
+
+namespace {
+const int kFirstPid{1000};
+const char* const kComms[] = {"worker", "Web Content", "(sd-pam)",
+                              "kworker/0:1", "a) b (c"};
+
+bool WriteFile(const string& path, const string& content) {
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written =
+      std::fwrite(content.data(), 1, content.size(), file) == content.size();
+  return std::fclose(file) == 0 && written;
+}
+
+string Stat(int cores, int pids, int tick) {
+  string stat;
+  char line[256];
+  for (int cpu = -1; cpu < cores; ++cpu) {
+    int scale = cpu < 0 ? cores : 1;
+    unsigned long base = 100000UL + tick * 100UL;
+    std::snprintf(line, sizeof(line),
+                  "cpu%s %lu %lu %lu %lu %lu %lu %lu %lu 0 0\n",
+                  cpu < 0 ? " " : std::to_string(cpu).c_str(),
+                  scale * (base + tick * 37UL), scale * base / 50,
+                  scale * (base / 4 + tick * 11UL),
+                  scale * (base * 4 + tick * 50UL), scale * base / 100,
+                  scale * 10UL, scale * 20UL, 0UL);
+    stat += line;
+  }
+  std::snprintf(line, sizeof(line),
+                "intr 0\nctxt 0\nbtime 0\nprocesses %d\nprocs_running %d\n"
+                "procs_blocked 0\n",
+                pids * 3, 2 + pids / 100);
+  return stat + line;
+}
+
+string PidStat(int pid, int tick) {
+  char line[512];
+  const char* comm = kComms[pid % 5];
+  // PIDs run at about a hundred different speeds, so orders by cpu
+  // usage have few ties
+  long utime = (pid % 97) * 10 + tick * (pid * 7919L % 101);
+  std::snprintf(line, sizeof(line),
+                "%d (%s) S 1 %d %d 0 -1 4194560 1200 0 3 0 %ld %ld 0 0 20 0 "
+                "%d 0 %d 123456789 %d 18446744073709551615 1 1 0 0 0 0 0 "
+                "4096 0 0 0 0 17 %d 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+                pid, comm, pid, pid, utime, utime / 3, 1 + pid % 8,
+                100 + pid % 5000, 200 + pid % 20000, pid % 4);
+  return line;
+}
+
+string PidStatus(int pid) {
+  char status[1024];
+  int uid = pid % 3 == 0 ? 0 : 1000;
+  std::snprintf(status, sizeof(status),
+                "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%d\n"
+                "Ngid:\t0\nPid:\t%d\nPPid:\t1\nTracerPid:\t0\n"
+                "Uid:\t%d\t%d\t%d\t%d\nGid:\t%d\t%d\t%d\t%d\nFDSize:\t64\n"
+                "Groups:\t\nNStgid:\t%d\nNSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n"
+                "Kthread:\t0\nVmPeak:\t  123456 kB\nVmSize:\t  120000 kB\n"
+                "VmLck:\t       0 kB\nVmPin:\t       0 kB\nVmHWM:\t   %d kB\n"
+                "VmRSS:\t   %d kB\nRssAnon:\t    %d kB\nRssFile:\t    4000 kB\n"
+                "RssShmem:\t       0 kB\nVmData:\t   50000 kB\n"
+                "VmStk:\t     132 kB\nVmExe:\t     200 kB\nVmLib:\t    8000 kB\n"
+                "VmPTE:\t     100 kB\nVmSwap:\t       0 kB\nThreads:\t%d\n",
+                kComms[pid % 5], pid, pid, uid, uid, uid, uid, uid, uid, uid,
+                uid, pid, pid, pid, pid, 900 + pid % 20000,
+                800 + pid % 20000, 400 + pid % 10000, 1 + pid % 8);
+  return status;
+}
+
+string SmapsRollup(int pid) {
+  char smaps[512];
+  int rss = 800 + pid % 20000;
+  std::snprintf(smaps, sizeof(smaps),
+                "55d0c0000000-7ffc00000000 ---p 00000000 00:00 0    [rollup]\n"
+                "Rss:             %d kB\nPss:             %d kB\n"
+                "Shared_Clean:       4000 kB\nShared_Dirty:          0 kB\n"
+                "Private_Clean:       %d kB\nPrivate_Dirty:       %d kB\n"
+                "Swap:                  0 kB\nSwapPss:               0 kB\n",
+                rss, rss / 2, rss / 8, rss / 4);
+  return smaps;
+}
+
+string Io(int pid) {
+  char io[256];
+  std::snprintf(io, sizeof(io),
+                "rchar: %d\nwchar: %d\nsyscr: 10\nsyscw: 5\nread_bytes: %d\n"
+                "write_bytes: %d\ncancelled_write_bytes: 0\n",
+                pid * 40, pid * 20, pid * 8, pid * 4);
+  return io;
+}
+
+string Cmdline(int pid) {
+  string cmdline = "/usr/bin/worker";
+  cmdline += '\0';
+  cmdline += "--id";
+  cmdline += '\0';
+  cmdline += std::to_string(pid);
+  cmdline += '\0';
+  return cmdline;
+}
+}  // namespace
+
+bool ProcFixture::Generate(const string& directory, int pids, int cores) {
+  mkdir(directory.c_str(), 0755);
+  bool ok = WriteFile(directory + "/meminfo",
+                      "MemTotal:       16000000 kB\n"
+                      "MemFree:         4000000 kB\n"
+                      "MemAvailable:    9000000 kB\n"
+                      "Buffers:          500000 kB\n"
+                      "Cached:          4000000 kB\n"
+                      "SwapTotal:       2000000 kB\n"
+                      "SwapFree:        1500000 kB\n");
+  ok = ok && WriteFile(directory + "/uptime", "12345.67 45678.90\n");
+  ok = ok && WriteFile(directory + "/version",
+                       "Linux version 6.1.0-fixture (bench@fixture) #1 SMP\n");
+  for (int i = 0; ok && i < pids; ++i) {
+    int pid = kFirstPid + i;
+    string pid_directory = directory + "/" + std::to_string(pid);
+    mkdir(pid_directory.c_str(), 0755);
+    ok = WriteFile(pid_directory + "/status", PidStatus(pid)) &&
+         WriteFile(pid_directory + "/cmdline", Cmdline(pid)) &&
+         WriteFile(pid_directory + "/smaps_rollup", SmapsRollup(pid)) &&
+         WriteFile(pid_directory + "/io", Io(pid));
+  }
+  return ok && Tick(directory, pids, cores, 0);
+}
+
+bool ProcFixture::TickStat(const string& directory, int pids, int cores,
+                           int tick) {
+  return WriteFile(directory + "/stat", Stat(cores, pids, tick));
+}
+
+bool ProcFixture::Tick(const string& directory, int pids, int cores,
+                       int tick) {
+  return Tick(directory, pids, cores, tick, 1);
+}
+
+bool ProcFixture::Tick(const string& directory, int pids, int cores,
+                       int tick, int stride) {
+  bool ok = TickStat(directory, pids, cores, tick);
+  for (int i = tick % stride; ok && i < pids; i += stride) {
+    int pid = kFirstPid + i;
+    ok = WriteFile(directory + "/" + std::to_string(pid) + "/stat",
+                   PidStat(pid, tick));
+  }
+  return ok;
+}
@@ -0,0 +1,24 @@
+#ifndef PROC_FIXTURE_H
+#define PROC_FIXTURE_H
+
+#include <string>
+
+/*
+Synthetic /proc-like tree for benchmarks: the system files read by
+LinuxParser plus a stat, status and cmdline file for every PID. Some
+comm fields contain blanks and parentheses like real ones do
+*/
+namespace ProcFixture {
+// false if a file could not be written
+bool Generate(const std::string& directory, int pids, int cores);
+// advance the cpu counters of the tree as if seconds had passed
+bool Tick(const std::string& directory, int pids, int cores, int tick);
+// same for the stat files of every stride-th PID only, from an offset
+// turning with tick, the others keep the counters of an earlier tick
+bool Tick(const std::string& directory, int pids, int cores, int tick,
+          int stride);
+// same for the system wide /stat only
+bool TickStat(const std::string& directory, int pids, int cores, int tick);
+};  // namespace ProcFixture
+
+#endif
@@ -0,0 +1,19 @@
+#include <cstdio>
+#include <string>
+
+#include "proc_fixture.h"
+
+// Usage: proc_fixture DIR PIDS [CORES]
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::fprintf(stderr, "usage: %s DIR PIDS [CORES]\n", argv[0]);
+    return 1;
+  }
+  int pids = std::stoi(argv[2]);
+  int cores = argc > 3 ? std::stoi(argv[3]) : 8;
+  if (!ProcFixture::Generate(argv[1], pids, cores)) {
+    std::perror(argv[1]);
+    return 1;
+  }
+  return 0;
+}
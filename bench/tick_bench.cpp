@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process.h"
+#include "process_store.h"
+#include "system_snapshot.h"
+#include "worker_pool.h"
+
+/*
+Scaling of the per process sampling with the number of threads.
+The live PIDs are repeated until the wanted process count is reached,
+so every refresh does the same /proc reads as a host of that size
+Usage: tick_bench [ticks per case]
+*/
+
+namespace {
+const size_t kChunk{32};
+
+double TickMilliseconds(std::vector<Process>& processes, WorkerPool& pool,
+                        const SystemSnapshot& snapshot, int ticks) {
+  std::vector<double> samples;
+  for (int tick = 0; tick < ticks; ++tick) {
+    auto start = std::chrono::steady_clock::now();
+    pool.ParallelFor(processes.size(), kChunk,
+                     [&processes, &snapshot](size_t begin, size_t end) {
+                       for (size_t i = begin; i < end; ++i) {
+                         processes[i].refresh(snapshot);
+                       }
+                     });
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    samples.push_back(elapsed.count());
+  }
+  // median of the ticks
+  std::nth_element(samples.begin(), samples.begin() + samples.size() / 2,
+                   samples.end());
+  return samples[samples.size() / 2];
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int ticks = argc > 1 ? std::stoi(argv[1]) : 5;
+  // the median needs a measured tick
+  if (ticks < 1) {
+    std::fprintf(stderr, "usage: %s [ticks per case >= 1]\n", argv[0]);
+    return 1;
+  }
+  std::vector<int> pids = LinuxParser::Pids();
+  const size_t counts[] = {1000, 10000, 50000};
+  const unsigned int thread_counts[] = {1, 2, 4, 8};
+
+  std::printf("%10s", "processes");
+  for (unsigned int threads : thread_counts) {
+    std::printf(" %8u thr", threads);
+  }
+  std::printf("   (median ms per tick)\n");
+  for (size_t count : counts) {
+    // a PID repeats, so the rows are added without a ProcessTable
+    ProcessStore store;
+    std::vector<Process> processes;
+    for (size_t i = 0; i < count; ++i) {
+      processes.emplace_back(store, store.Add(pids[i % pids.size()]));
+    }
+    SystemSnapshot snapshot = SystemSnapshot::Capture();
+    std::printf("%10zu", count);
+    for (unsigned int threads : thread_counts) {
+      WorkerPool pool(threads);
+      // warm up, the first tick grows the read buffers and comm strings
+      TickMilliseconds(processes, pool, snapshot, 1);
+      std::printf(" %12.2f", TickMilliseconds(processes, pool, snapshot, ticks));
+      std::fflush(stdout);
+    }
+    std::printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <sys/types.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "process.h"
+#include "process_filter.h"
+#include "processor.h"
+#include "system_snapshot.h"
+#include "worker_pool.h"
+
+// A rule which fired, for the system or for one process
+struct Alert {
+  std::string rule;     // text of the rule
+  int pid{0};           // 0 for a system rule
+  std::string command;  // name of the process
+  int64_t since_ms{0};  // wall clock when it fired
+};
+
+struct AlertEvent {
+  Alert alert;
+  bool fired{true};    // false when it cleared
+  int64_t time_ms{0};  // wall clock of the tick
+};
+
+/*
+Threshold rules evaluated every tick, for example
+  cpu>90 for 30s clear cpu<80
+  process rss_growth>50 for 2m
+  process state==D for 5 ticks
+A system rule compares one of cpu, iowait, steal, memory or swap in %
+with a number, a process rule is a ProcessFilter expression tested on
+every process. A rule fires once its condition held for the duration,
+and clears once its clear condition, by default the condition being
+false, held as long, so a value around the threshold doesn't flap.
+Only the processes whose condition holds have a state kept per PID, so
+the cost of a tick follows the number of processes and not the number
+of pending alerts
+*/
+class Alerts {
+ public:
+  // false with a message in error when text isn't a rule
+  bool Add(const std::string& text, std::string& error);
+  bool Empty() const;
+  // evaluate every rule on the tick, the process fields are fetched by
+  // the predicates when live. now_ms stamps the alerts which fire
+  void Update(std::vector<Process>& processes, const CpuShare& cpu,
+              const SystemSnapshot& snapshot, unsigned int tick, bool live,
+              int64_t now_ms, WorkerPool& pool);
+  // oldest first
+  const std::vector<Alert>& Firing() const;
+  // alerts fired or cleared by the last Update()
+  const std::vector<AlertEvent>& Events() const;
+
+ private:
+  enum class Field { kCpu, kIowait, kSteal, kMemory, kSwap };
+  enum class Operator { kLess, kLessEqual, kGreater, kGreaterEqual };
+  struct Comparison {
+    Field field{Field::kCpu};
+    Operator op{Operator::kGreater};
+    double number{0};
+  };
+  struct Track {
+    long start_time{-1};  // of the process, tells a reused PID apart
+    double since{0};      // Seconds() when the condition started holding
+    long ticks{0};        // ticks it has held
+    bool firing{false};
+    Alert alert;  // while firing
+    std::size_t index{0};        // of the process when last seen
+    unsigned int generation{0};  // last Update() the condition held
+  };
+  struct Rule {
+    std::string text;
+    bool process{false};
+    Comparison when;  // system rules
+    Comparison clear;
+    bool has_clear{false};
+    ProcessFilter process_when;  // process rules
+    ProcessFilter process_clear;
+    double seconds{0};  // duration, in seconds or in ticks
+    long ticks{0};
+    Track track;  // of a system rule
+    std::unordered_map<int, Track> tracks;  // of a process rule, by PID
+  };
+
+  static bool Parse(const std::string& text, Comparison& comparison);
+  static bool Holds(const Comparison& comparison, const CpuShare& cpu,
+                    const SystemSnapshot& snapshot);
+  // advance track by one tick, true when it fired or cleared
+  static bool Step(const Rule& rule, Track& track, bool holds, double now);
+  void Emit(Track& track, bool fired, int64_t now_ms);
+  // process of a track, nullptr when it is gone
+  Process* Locate(std::vector<Process>& processes, int pid, Track& track);
+
+  std::vector<Rule> rules_;
+  std::vector<char> holds_;  // rule by process, scratch of Update()
+  std::vector<std::size_t> process_rules_;
+  // PID to process, built by Locate() when processes moved
+  std::unordered_map<int, std::size_t> positions_;
+  bool positioned_{false};
+  std::vector<Alert> firing_;
+  std::vector<AlertEvent> events_;
+  unsigned int generation_{0};
+};
+
+/*
+Writes the events of the alerts in headless mode, one line each to
+stdout or appended to a file, and starts a hook command through /bin/sh
+for each with the alert in MONITOR_ALERT_* environment variables. At
+most kMaxHooks hooks run at once, the events of the others wait in a
+queue of kMaxQueued, and the events beyond it are dropped with their
+count written out. The hooks run without being waited for, they are
+reaped on later writes. On destruction they get a grace period to
+finish, then they are terminated and at last killed
+*/
+class AlertOutput {
+ public:
+  static const std::size_t kMaxHooks{4};
+  static const std::size_t kMaxQueued{1024};
+
+  ~AlertOutput();
+  // empty path writes to stdout
+  bool Open(const std::string& path);
+  void Hook(const std::string& command);
+  void Write(const std::vector<AlertEvent>& events);
+
+ private:
+  void Run(const AlertEvent& event);
+  void Reap();
+  void Wait(std::chrono::milliseconds timeout);
+
+  FILE* file_{nullptr};
+  std::string hook_;
+  std::vector<pid_t> hooks_;  // running
+  std::deque<AlertEvent> queued_;
+  unsigned long dropped_{0};  // since the last write
+};
+
+#endif
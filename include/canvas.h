@@ -0,0 +1,37 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <curses.h>
+
+#include <vector>
+
+/*
+The screen as a frame of curses cells. Drawing only changes the frame,
+Flush() compares it with the frame shown last and hands curses the
+spans of changed cells, so a tick which changes a few numbers sends a
+few characters to the terminal
+*/
+class Canvas {
+ public:
+  // blank frame, the next Flush() redraws every cell
+  void Resize(int rows, int columns);
+  int Rows() const;
+  int Columns() const;
+  // blank the frame which is drawn next
+  void Clear();
+  // text from column, clipped before end (the right edge when -1)
+  void Put(int row, int column, const char* text,
+           attr_t attributes = A_NORMAL, int end = -1);
+  void Put(int row, int column, chtype cell);
+  void Box(int top, int left, int height, int width);
+  // false when no cell changed
+  bool Flush(WINDOW* window);
+
+ private:
+  int rows_{0};
+  int columns_{0};
+  std::vector<chtype> cells_;
+  std::vector<chtype> shown_;
+};
+
+#endif
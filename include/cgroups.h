@@ -0,0 +1,60 @@
+#ifndef CGROUPS_H
+#define CGROUPS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "process.h"
+#include "system_snapshot.h"
+
+// A cgroup v2 group of processes over the last interval
+struct CgroupStats {
+  std::string path;
+  int processes{0};
+  float cpu_utilization{0};  // share of all cpus, like a process
+  float throttled{-1};       // share of the periods throttled, -1 unknown
+  long memory_kb{0};
+  // "some avg10" of the pressure files in %, -1 without the file
+  float cpu_pressure{-1};
+  float memory_pressure{-1};
+  float io_pressure{-1};
+};
+
+/*
+Processes grouped by their cgroup v2 path. The files of a group are
+read once per Update() whatever its number of processes, the path of a
+process is fetched once per PID by Process::Fetch(kCgroupField).
+Groups without cpu.stat or memory.current sum the cpu usage and rss of
+their processes instead, and so does the root, whose files count every
+process of the system
+*/
+class Cgroups {
+ public:
+  // finds the v2 hierarchy, mounted on kCgroupPath or below it in
+  // "unified" on hosts which still mount v1 hierarchies
+  Cgroups();
+  // processes need kStatField and kCgroupField of the tick, the ones
+  // the filter rejected are left out
+  void Update(std::vector<Process>& processes, const SystemSnapshot& snapshot);
+  // busiest first
+  const std::vector<CgroupStats>& Groups() const;
+
+ private:
+  struct Previous {
+    uint64_t usage_usec{0};
+    uint64_t periods{0};
+    uint64_t throttled{0};
+    double seconds{0};
+  };
+
+  void Read(CgroupStats& group, const SystemSnapshot& snapshot);
+
+  std::string root_;
+  std::unordered_map<std::string, Previous> previous_;
+  std::unordered_map<std::string, size_t> index_;  // path to groups_
+  std::vector<CgroupStats> groups_;
+};
+
+#endif
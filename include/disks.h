@@ -0,0 +1,34 @@
+#ifndef DISKS_H
+#define DISKS_H
+
+#include <string>
+#include <vector>
+
+#include "system_snapshot.h"
+
+// Throughput of a block device over the last interval
+struct DiskRate {
+  std::string name;
+  float read_bytes{0};  // per second
+  float write_bytes{0};
+  float iops{0};         // reads and writes completed per second
+  float utilization{0};  // share of the time with requests in flight
+};
+
+/*
+Rates of the devices of /proc/diskstats between two snapshots, like
+Processor does for the cpu lines. Devices are matched by name, so a
+device which appears starts from its counters since boot
+*/
+class Disks {
+ public:
+  void Update(const SystemSnapshot& snapshot);
+  const std::vector<DiskRate>& Rates() const;
+
+ private:
+  std::vector<LinuxParser::Disk> previous_;
+  double previous_seconds_{0};
+  std::vector<DiskRate> rates_;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "process.h"
+#include "system.h"
+
+/*
+Serves the last tick over HTTP on a localhost TCP port or a Unix
+socket: GET /metrics in the Prometheus text format and GET /json as one
+JSON line. Both responses are serialized once per tick by Publish() and
+shared by every request, so scrapers never cause a /proc read
+*/
+class Exporter {
+ public:
+  // processes exported per tick, in the order of the system's sort key
+  static const int kProcesses{25};
+
+  Exporter() = default;
+  ~Exporter();
+  Exporter(const Exporter&) = delete;
+  Exporter& operator=(const Exporter&) = delete;
+
+  // address is a port on 127.0.0.1, or the path of a Unix socket when
+  // it contains a '/', false with errno set when it can't be bound
+  bool Listen(const std::string& address);
+  void Publish(System& system, std::vector<Process>& processes);
+
+ private:
+  struct Responses {
+    std::string metrics;
+    std::string json;
+  };
+  void Serve();
+  std::shared_ptr<const Responses> Latest();
+
+  int listener_{-1};
+  int wake_{-1};  // eventfd ending Serve()
+  std::string socket_path_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::shared_ptr<const Responses> responses_;
+};
+
+#endif
@@ -1,10 +1,15 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <cstddef>
 #include <string>
 
 namespace Format {
 std::string ElapsedTime(long times);  // DONE: See src/format.cpp
+// HH:MM:SS into buffer without allocating, returns buffer
+char* ElapsedTime(long seconds, char* buffer, std::size_t size);
+// local date and time of a wall clock in seconds, YYYY-MM-DD HH:MM:SS
+std::string DateTime(long seconds);
 };                                    // namespace Format
 
 #endif
\ No newline at end of file
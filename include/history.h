@@ -0,0 +1,92 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "process.h"
+#include "processor.h"
+#include "ring_buffer.h"
+#include "system_snapshot.h"
+
+// Summary of a series over a time window
+struct SeriesStats {
+  float min{0};
+  float avg{0};
+  float max{0};
+  float p95{0};
+  std::size_t points{0};
+};
+
+/*
+History of one value at two resolutions: 1 s points for 10 minutes and
+10 s points for 6 hours. Samples are averaged into the points of both
+resolutions, so the memory of a series is fixed however long it runs.
+Points are stamped with their bucket and queried by time, buckets
+without samples, as with long intervals or while a process was out of
+the top rows, are gaps and not points of another time
+*/
+class Series {
+ public:
+  Series();
+  void Add(long second, float value);
+  // over the last seconds, from the finest resolution covering them
+  SeriesStats Query(long seconds) const;
+  // the 1 s points of the latest count seconds, oldest first
+  void Latest(std::size_t count, std::vector<float>& points) const;
+
+ private:
+  struct Point {
+    long bucket;
+    float value;
+  };
+  struct Level {
+    Level(long width, std::size_t capacity);
+    void Add(long second, float value);
+    // position of the first point of the buckets after second - seconds
+    std::size_t Since(long second, long seconds) const;
+
+    RingBuffer<Point> points;
+    long width;  // seconds per point
+    long bucket{-1};
+    double sum{0};
+    int count{0};
+  };
+
+  Level fine_;
+  Level coarse_;
+  long second_{0};  // of the latest sample
+};
+
+/*
+Series of the system CPU, every core, the memory and the CPU and RSS of
+the processes which were recently among the top rows
+*/
+class History {
+ public:
+  void Add(long second, const Processor& cpu, const SystemSnapshot& snapshot,
+           std::vector<Process>& top);
+  const Series& Cpu() const;
+  const Series& Core(int core) const;
+  const Series& Memory() const;
+  // nullptr when the process was not among the top rows recently
+  const Series* ProcessCpu(int pid) const;
+  const Series* ProcessRss(int pid) const;
+
+ private:
+  struct ProcessSeries {
+    long start_time{0};
+    long last_seen{0};
+    Series cpu;
+    Series rss;
+  };
+  void Evict(long second);
+
+  Series cpu_;
+  std::vector<Series> cores_;
+  Series memory_;
+  std::unordered_map<int, ProcessSeries> processes_;
+};
+
+#endif
@@ -1,25 +1,98 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <regex>
 #include <string>
+#include <vector>
+
+#include "proc_reader.h"
 
 namespace LinuxParser {
 // Paths
 const std::string kProcDirectory{"/proc/"};
 const std::string kCmdlineFilename{"/cmdline"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
+const std::string kIoFilename{"/io"};
+const std::string kDiskstatsFilename{"/diskstats"};
+const std::string kCgroupFilename{"/cgroup"};
+const std::string kCgroupPath{"/sys/fs/cgroup"};
+const std::string kNetDevFilename{"/net/dev"};
+const std::string kNetSnmpFilename{"/net/snmp"};
+const std::string kSmapsRollupFilename{"/smaps_rollup"};
 const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
+const std::string kTaskDirectory{"/task"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
 
+// The proc root defaults to kProcDirectory, a synthetic tree can be
+// used instead. Change it only while nothing is reading. False with errno
+// set when directory can't be opened, nothing is read from /proc then
+bool ProcDirectory(const std::string& directory);
+const std::string& ProcDirectory();
+// Interfaces whose name matches one of the comma separated globs are
+// read, every one when empty. Change it only while nothing is reading
+void Interfaces(const std::string& globs);
+
 // System
+// kB of /proc/meminfo, read by key
+struct Memory {
+  long total_kb{0};
+  long free_kb{0};
+  long available_kb{0};
+  long buffers_kb{0};
+  long cached_kb{0};
+  long swap_total_kb{0};
+  long swap_free_kb{0};
+};
+Memory MemoryInfo();
+
+// counters of a block device line of /proc/diskstats, sectors are 512
+// bytes whatever the device
+struct Disk {
+  std::string name;
+  uint64_t reads{0};  // completed
+  uint64_t read_sectors{0};
+  uint64_t writes{0};
+  uint64_t write_sectors{0};
+  uint64_t io_ms{0};  // time the device had requests in flight
+};
+// devices which did any I/O since boot
+void DiskStats(std::vector<Disk>& disks);
+
+// counters of /proc/net/dev and the Tcp lines of /proc/net/snmp, in
+// fixed arrays so a tick copies them without allocating
+const std::size_t kInterfaces{16};  // read at most, in the order of the file
+const std::size_t kInterfaceName{16};  // IFNAMSIZ
+struct InterfaceCounters {
+  std::array<char, kInterfaceName> name{};
+  uint64_t rx_bytes{0};
+  uint64_t rx_packets{0};
+  uint64_t rx_errors{0};
+  uint64_t rx_drops{0};
+  uint64_t tx_bytes{0};
+  uint64_t tx_packets{0};
+  uint64_t tx_errors{0};
+  uint64_t tx_drops{0};
+};
+struct NetworkCounters {
+  std::array<InterfaceCounters, kInterfaces> interfaces{};
+  std::size_t count{0};
+  std::size_t hidden{0};  // matching interfaces past kInterfaces, not read
+  uint64_t tcp_in_segments{0};
+  uint64_t tcp_out_segments{0};
+  uint64_t tcp_retransmits{0};
+};
+void NetworkStats(NetworkCounters& network);
+// MemTotal less MemAvailable, page cache which can be dropped is free
 float MemoryUtilization();
+float MemoryUtilization(const Memory& memory);
 long UpTime();
 std::vector<int> Pids();
 int TotalProcesses();
@@ -40,23 +113,61 @@ enum CPUStates {
   kGuest_,
   kGuestNice_
 };
+const int kCpuStates{kGuestNice_ + 1};
 std::vector<std::string> CpuUtilization();
+std::vector<uint64_t> CpuJiffies();
+void CpuJiffies(std::vector<uint64_t>& jiffies);
+// the process counters of /proc/stat, from the read of its cpu lines
+struct ProcessCounts {
+  int total{0};  // forks since boot
+  int running{0};
+};
+void CpuJiffies(std::vector<uint64_t>& jiffies, ProcessCounts& processes);
 long Jiffies();
 long ActiveJiffies();
 long ActiveJiffies(int pid);
 long IdleJiffies();
+// computations over the kCpuStates counters of an already parsed cpu line
+long Jiffies(const uint64_t* cpu_jiffies);
+long ActiveJiffies(const uint64_t* cpu_jiffies);
+long IdleJiffies(const uint64_t* cpu_jiffies);
 
 // Helper functions
 std::string GetFileLineDataByKey(const std::string& filename, const std::string& key);
 std::string GetFileLineData(const std::string &filename, unsigned int line_no);
-std::string GetPasswdUserData(unsigned int uid);
 
 // Processes
+bool ProcessStat(int pid, ProcReader::PidStat& stat);
 std::string Command(int pid);
 std::string Uid(int pid);
 std::string User(int pid);
+// effective uid of a process, -1 when it is gone
+long Owner(int pid);
+std::string UserName(long uid);
 long int UpTime(int pid);
 unsigned int Ram(int pid);
+// path of the process in the cgroup v2 hierarchy, "/" without one
+std::string Cgroup(int pid);
+// kB of /proc/[pid]/smaps_rollup, which walks every mapping of the
+// process, uss is the memory no other process shares
+struct Smaps {
+  long rss_kb{0};
+  long pss_kb{0};
+  long uss_kb{0};
+};
+bool SmapsRollup(int pid, Smaps& smaps);
+
+// bytes a process caused to be fetched from or sent to storage, false
+// when the io file can't be read, ProcReader::LastError() tells why
+struct Io {
+  long read_bytes{0};
+  long write_bytes{0};
+};
+bool ProcessIo(int pid, Io& io);
+
+// Threads
+void Tids(int pid, std::vector<int>& tids);
+bool ThreadStat(int pid, int tid, ProcReader::PidStat& stat);
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
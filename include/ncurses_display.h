@@ -3,14 +3,64 @@
 
 #include <curses.h>
 
+#include <cstddef>
+#include <vector>
+
+#include "canvas.h"
 #include "process.h"
-#include "system.h"
+#include "sample.h"
+#include "sampler.h"
 
+/*
+Every frame is drawn into a Canvas which sends only the changed cells
+to the terminal. The panels are drawn at a row of the canvas and are
+width columns wide, their text is clipped inside their box. The threads
+of expanded processes take rows of the process panel under their process
+*/
 namespace NCursesDisplay {
-void Display(System& system, int n = 10);
-void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
-std::string ProgressBar(float percent);
+void Display(Sampler& sampler, int n = 10);
+const int kCoreCellWidth{20};
+const long kReplaySeek{60};  // ticks moved by one seek key
+const std::size_t kExpandTop{3};  // rows expanded by the top threads key
+// rows of the system panel
+const int kSystemRows{13};
+// devices shown by the disk panel, the busiest ones
+const std::size_t kDiskRows{4};
+// interfaces shown by the network panel, the busiest ones
+const std::size_t kInterfaceRows{4};
+void DisplaySystem(const Sample& sample, Canvas& canvas, int top, int width);
+void DisplayCores(const std::vector<CpuShare>& shares, Canvas& canvas,
+                  int top, int width);
+// no rows without devices, as in a replay
+int DiskPanelRows(const std::vector<DiskRate>& disks);
+void DisplayDisks(const std::vector<DiskRate>& disks, Canvas& canvas, int top,
+                  int width);
+int NetworkPanelRows(const NetworkRates& network);
+void DisplayNetwork(const NetworkRates& network, Canvas& canvas, int top,
+                    int width);
+// firing alerts shown by the alert panel, the oldest ones
+const std::size_t kAlertRows{4};
+// no rows without firing alerts
+int AlertPanelRows(const std::vector<Alert>& alerts);
+void DisplayAlerts(const std::vector<Alert>& alerts, Canvas& canvas, int top,
+                   int width);
+// in tree order the commands are indented by depth, and the cpu and
+// ram columns sum the subtrees. Processes with a firing alert are red
+void DisplayProcesses(const std::vector<ProcessSample>& processes,
+                      Canvas& canvas, int top, int width, int n,
+                      SortKey key = SortKey::kCpu, int selected = -1,
+                      bool tree = false);
+// the groups instead of the processes, the path is shortened from the
+// left as the pod and container are at its end
+void DisplayCgroups(const std::vector<CgroupStats>& groups, Canvas& canvas,
+                    int top, int width, int n);
+void DisplaySelfStats(const Sample& sample, Canvas& canvas, int top, int left,
+                      int width);
+// "0%", 50 bars and the percentage, written into buffer
+char* ProgressBar(float percent, char* buffer, std::size_t size);
+// one character per point from low to high, written into buffer
+char* Sparkline(const std::vector<float>& points, float scale, char* buffer,
+                std::size_t size);
 };  // namespace NCursesDisplay
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,46 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <array>
+#include <cstddef>
+
+#include "linux_parser.h"
+#include "system_snapshot.h"
+
+// Per second rates of an interface over the last interval
+struct InterfaceRate {
+  std::array<char, LinuxParser::kInterfaceName> name{};
+  float rx_bytes{0};
+  float tx_bytes{0};
+  float rx_packets{0};
+  float tx_packets{0};
+  float errors{0};  // received and transmitted
+  float drops{0};
+};
+
+struct NetworkRates {
+  std::array<InterfaceRate, LinuxParser::kInterfaces> interfaces{};
+  std::size_t count{0};
+  std::size_t hidden{0};  // interfaces not read, past the first ones
+  float tcp_in_segments{0};
+  float tcp_out_segments{0};
+  float tcp_retransmits{0};
+};
+
+/*
+Rates of the interfaces of /proc/net/dev and of the TCP segments
+between two snapshots, like Disks. Only the interfaces the snapshot
+kept after the glob filter get a rate
+*/
+class Network {
+ public:
+  void Update(const SystemSnapshot& snapshot);
+  const NetworkRates& Rates() const;
+
+ private:
+  LinuxParser::NetworkCounters previous_;
+  double previous_seconds_{0};
+  NetworkRates rates_;
+};
+
+#endif
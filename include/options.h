@@ -0,0 +1,30 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <string>
+#include <vector>
+
+/*
+Command line options of the monitor
+*/
+struct Options {
+  // false on unknown options or missing values
+  static bool Parse(int argc, char* argv[], Options& options);
+  static void PrintUsage(const char* program);
+
+  unsigned int threads{0};  // 0 keeps the default of System
+  unsigned int interval_ms{1000};
+  std::string proc_root;  // empty keeps /proc
+  bool events{false};     // discover processes through the proc connector
+  std::string record;     // headless recording into this file
+  std::string replay;     // show this recording instead of the system
+  std::string address;    // headless exporter on this port or socket
+  std::string interfaces;  // comma separated globs, empty reads all
+  std::string filter;      // process filter expression, see ProcessFilter
+  std::vector<std::string> alerts;  // alert rules, see Alerts
+  std::string alert_log;   // alert events of the headless modes, or stdout
+  std::string alert_hook;  // shell command run for every alert event
+  bool headless{false};    // evaluate the alerts only, no display
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef PASSWD_CACHE_H
+#define PASSWD_CACHE_H
+
+#include <sys/types.h>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+Index of uid to user name built from the passwd file.
+The file is parsed once and parsed again only when its inode or mtime
+changes, users missing from the file are resolved through NSS with
+getpwuid_r, outside the lock, and kept in the same index. A uid NSS
+doesn't know is shown as its number and asked again after a while.
+Lookups are thread safe
+*/
+class PasswdCache {
+ public:
+  explicit PasswdCache(std::string path);
+  std::string Name(unsigned int uid);
+
+ private:
+  void ReloadIfChanged();
+  void Load();
+
+  std::mutex mutex_;
+  std::string path_;
+  std::unordered_map<unsigned int, std::string> names_;
+  // uids unknown to NSS, until when they aren't asked again
+  std::unordered_map<unsigned int, std::chrono::steady_clock::time_point>
+      unknown_;
+  dev_t device_{0};
+  ino_t inode_{0};
+  timespec mtime_{0, 0};
+  std::chrono::steady_clock::time_point next_check_{};
+};
+
+#endif
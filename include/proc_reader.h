@@ -0,0 +1,128 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Allocation free reading and scanning of /proc files.
+Files are read with raw open/read into a buffer owned by the calling
+thread, and the returned views stay valid until the next read made by
+the same thread. Paths under /proc are opened relative to a cached
+directory descriptor of the proc root.
+*/
+namespace ProcReader {
+// Use another directory as the proc root, "/proc" by default. False with
+// errno set when it can't be opened, every read fails until the next call
+bool Root(const char* directory);
+// Read a file relative to the proc root, e.g. "stat" or "meminfo"
+std::string_view Read(const char* relative_path);
+// Read /proc/[pid]/[name]
+std::string_view ReadPid(int pid, const char* name);
+// Read a file by its absolute path (e.g. /etc/os-release)
+std::string_view ReadPath(const char* path);
+// PIDs of the proc root, listed with getdents64 without a path per entry
+void Pids(std::vector<int>& pids);
+// numbered entries of a directory relative to the proc root
+void Pids(const char* relative_directory, std::vector<int>& pids);
+// owner of /proc/[pid], the effective uid of the process, with one
+// fstatat and no file read
+bool Owner(int pid, unsigned int& uid);
+// Number of bytes read by the calling thread so far
+unsigned long BytesRead();
+// errno of the last read made by the calling thread, 0 when it succeeded
+int LastError();
+
+// Scanners: all of them advance the cursor past what they consumed
+inline void SkipSpaces(std::string_view& cursor) {
+  size_t i = 0;
+  while (i < cursor.size() && (cursor[i] == ' ' || cursor[i] == '\t')) {
+    ++i;
+  }
+  cursor.remove_prefix(i);
+}
+
+inline bool ScanLong(std::string_view& cursor, long& value) {
+  SkipSpaces(cursor);
+  size_t i = 0;
+  bool negative = false;
+  if (i < cursor.size() && cursor[i] == '-') {
+    negative = true;
+    ++i;
+  }
+  size_t digits_start = i;
+  unsigned long result = 0;
+  while (i < cursor.size() && cursor[i] >= '0' && cursor[i] <= '9') {
+    result = result * 10 + static_cast<unsigned long>(cursor[i] - '0');
+    ++i;
+  }
+  if (i == digits_start) {
+    return false;
+  }
+  cursor.remove_prefix(i);
+  value = negative ? -static_cast<long>(result) : static_cast<long>(result);
+  return true;
+}
+
+inline bool ScanUnsigned(std::string_view& cursor, uint64_t& value) {
+  SkipSpaces(cursor);
+  size_t i = 0;
+  uint64_t result = 0;
+  while (i < cursor.size() && cursor[i] >= '0' && cursor[i] <= '9') {
+    result = result * 10 + static_cast<uint64_t>(cursor[i] - '0');
+    ++i;
+  }
+  if (i == 0) {
+    return false;
+  }
+  cursor.remove_prefix(i);
+  value = result;
+  return true;
+}
+
+// Next run of non blank characters, empty at the end of the line
+inline std::string_view NextToken(std::string_view& cursor) {
+  SkipSpaces(cursor);
+  size_t i = 0;
+  while (i < cursor.size() && cursor[i] != ' ' && cursor[i] != '\t' &&
+         cursor[i] != '\n') {
+    ++i;
+  }
+  std::string_view token = cursor.substr(0, i);
+  cursor.remove_prefix(i);
+  return token;
+}
+
+// Return the line at index line_no (starting from 0) without '\n'
+std::string_view NthLine(std::string_view text, unsigned int line_no);
+// Return the remainder of the first line starting with key
+std::string_view FindKey(std::string_view text, std::string_view key);
+// Read the first number found after key, or fallback if key is missing
+long ValueByKey(std::string_view text, std::string_view key, long fallback = 0);
+
+/*
+Fields of /proc/[pid]/stat. comm is enclosed by the first '(' and
+the last ')' of the line, as it may contain blanks and parentheses
+itself, numbered fields follow man 5 proc
+*/
+struct PidStat {
+  std::string_view comm;  // (2)
+  char state{'?'};        // (3)
+  long ppid{0};           // (4)
+  long utime{0};          // (14)
+  long stime{0};          // (15)
+  long cutime{0};         // (16)
+  long cstime{0};         // (17)
+  long num_threads{0};    // (20)
+  long starttime{0};      // (22)
+  long rss{0};            // (24)
+};
+bool ParsePidStat(std::string_view text, PidStat& stat);
+
+// Append the decimal representation of value to buffer, returns the end
+char* FormatInt(char* buffer, long value);
+};  // namespace ProcReader
+
+#endif
@@ -1,31 +1,99 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+
+#include "process_store.h"
+#include "recording.h"
+#include "system_snapshot.h"
+
+// Orders in which the process list can be shown
+enum class SortKey { kCpu = 0, kRss, kUpTime, kPid, kUser, kRead, kWrite };
+
+// Fields read from /proc, as bits of Process::Fetch()
+enum ProcessField : unsigned int {
+  kStatField = 1 << 0,  // cpu time, rss, start time, comm and state
+  kUserField = 1 << 1,  // uid and user name
+  kCommandField = 1 << 2,
+  kStatusField = 1 << 3,  // ram
+  kIoField = 1 << 4,      // storage bytes read and written
+  kCgroupField = 1 << 5,
+};
+// everything a row on screen shows
+const unsigned int kDisplayFields{kStatField | kUserField | kCommandField |
+                                  kStatusField | kIoField};
+
 /*
 Basic class for Process representation
-It contains relevant attributes as shown below
+It is a view of a row of a ProcessStore, the attributes below are read
+from and written to its columns. Copying a process into the top rows
+copies the view, which is valid until the row is removed or moved by
+the next ProcessTable::Update()
 */
 class Process {
  public:
-  explicit Process(int pid);
+  Process(ProcessStore& store, std::size_t index);
   int Pid() const;                         // DONE: See src/process.cpp
-  std::string User();                      // DONE: See src/process.cpp
-  std::string Command();                   // DONE: See src/process.cpp
+  int Ppid() const;
+  const std::string& User();               // DONE: See src/process.cpp
+  long Uid() const;  // -1 until read, and in a replay
+  // name and state from the stat file
+  const std::string& Comm() const;
+  char State() const;
+  const std::string& Command();            // DONE: See src/process.cpp
+  const std::string& Cgroup() const;
   float CpuUtilization();                  // DONE: See src/process.cpp
   std::string Ram();                       // DONE: See src/process.cpp
+  long RamKb();
+  long RssKb() const;
+  // rss growth in KB/s, smoothed over about a minute
+  float RssGrowth() const;
+  long StartTime() const;
+  long CpuJiffies() const;
+  // storage bytes since the start, and per second over the last interval
+  long ReadBytes() const;
+  long WriteBytes() const;
+  float ReadRate() const;
+  float WriteRate() const;
+  // proportional and unique set size from smaps_rollup, -1 until read
+  long PssKb() const;
+  long UssKb() const;
+  // read smaps_rollup when the last read is period_ms older than now_ms
+  void Smaps(long now_ms, long period_ms);
   long int UpTime();                       // DONE: See src/process.cpp
+  // false when the filter of the tick rejected the process
+  bool Matched() const;
+  void Match(bool matched);
   bool operator<(Process const& a) const;  // DONE: See src/process.cpp
-  void refresh();
+  bool Before(Process const& a, SortKey key) const;
+  // keys whose order is the ascending order of SortValue(), all but kUser
+  static bool Numeric(SortKey key);
+  double SortValue(SortKey key) const;
+  // fields the order of key needs for every process
+  static unsigned int Fields(SortKey key);
+  // read the fields not read yet during tick, user, command and cgroup
+  // are kept until the PID is reused or the process calls exec
+  void Fetch(unsigned int fields, const SystemSnapshot& snapshot,
+             unsigned int tick);
+  // read the stat file
+  void refresh(const SystemSnapshot& snapshot);
+  // the process called exec, user and command are fetched again
+  void Exec();
+  // replay: the values come from a recorded tick instead of /proc
+  void refresh(const SystemSnapshot& snapshot, const ProcessRecord& record);
 
   // DONE: Declare any necessary private members
  private:
-  int pid_;
-  std::string user_;
-  std::string command_;
-  float cpu_utilization_;
-  float prev_proc_cpu_time;
-  float prev_system_cpu_time;
+  ProcessStore* store_;
+  std::size_t index_;
+
+  // true when start_time is a new process behind the PID
+  bool Sample(const SystemSnapshot& snapshot, long start_time,
+              uint64_t cpu_jiffies);
+  void SampleIo(const SystemSnapshot& snapshot);
+  void SampleRss(const SystemSnapshot& snapshot, long rss_pages);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef PROCESS_DISCOVERY_H
+#define PROCESS_DISCOVERY_H
+
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+
+/*
+Set of the PIDs of the system. By default every call scans the proc
+root. After Listen() the set is kept up to date by the fork, exec and
+exit events of the netlink proc connector instead, and a full scan
+every kRescanInterval reconciles events the kernel dropped
+*/
+class ProcessDiscovery {
+ public:
+  static constexpr std::chrono::seconds kRescanInterval{10};
+
+  ProcessDiscovery() = default;
+  ~ProcessDiscovery();
+  ProcessDiscovery(const ProcessDiscovery&) = delete;
+  ProcessDiscovery& operator=(const ProcessDiscovery&) = delete;
+
+  // subscribe to the proc connector, false when the process lacks
+  // CAP_NET_ADMIN or the kernel has no connector, scans are kept then
+  bool Listen();
+  bool Listening() const;
+  // the PIDs, and the PIDs which called exec since the last call
+  void Pids(std::vector<int>& pids, std::vector<int>& execs);
+
+ private:
+  bool Drain(std::vector<int>& execs);
+  void Close();
+
+  int socket_{-1};
+  std::unordered_set<int> pids_;
+  std::vector<int> scan_;
+  std::chrono::steady_clock::time_point rescan_;
+};
+
+#endif
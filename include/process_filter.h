@@ -0,0 +1,120 @@
+#ifndef PROCESS_FILTER_H
+#define PROCESS_FILTER_H
+
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+/*
+A filter expression compiled into a tree of predicates, for example
+  user==svc && cpu>1 || cmd~java
+A predicate compares a field with a value. Predicates are joined by &&
+and ||, negated by ! and grouped by parentheses, and && binds tighter
+than ||. The numeric fields are pid, ppid, uid, cpu (%), rss and ram
+(MB), rss_growth (MB/min), read and write (KB/s) and time (s), compared
+with == != < <= > >=.
+The text fields are user, comm, cmd, state and cgroup, compared with
+== != and with ~ !~ for containing. Values holding blanks or operators
+are quoted with "".
+The operands of && and || are ordered from the cheapest field to the
+most expensive one, so the files a later operand needs are not read for
+a process which an earlier operand already decided
+*/
+class ProcessFilter {
+ public:
+  // false with a message in error when text isn't an expression, an
+  // empty text matches every process
+  static bool Compile(const std::string& text, ProcessFilter& filter,
+                      std::string& error);
+  bool Empty() const;
+  const std::string& Text() const;
+  // fetch(fields) is called with the ProcessField bits a predicate
+  // reads, right before it tests process
+  template <typename Fetch>
+  bool Matches(Process& process, Fetch fetch) const;
+
+ private:
+  enum class Kind { kAll, kAny, kNot, kTest };
+  enum class Field {
+    kPid,
+    kPpid,
+    kUid,
+    kUser,
+    kComm,
+    kState,
+    kCommand,
+    kCgroup,
+    kCpu,
+    kRss,
+    kRssGrowth,
+    kRam,
+    kRead,
+    kWrite,
+    kTime
+  };
+  enum class Operator {
+    kEqual,
+    kNotEqual,
+    kLess,
+    kLessEqual,
+    kGreater,
+    kGreaterEqual,
+    kContains,
+    kNotContains
+  };
+  struct Node {
+    Kind kind{Kind::kTest};
+    std::vector<int> operands;  // of kAll, kAny and kNot
+    Field field{Field::kPid};
+    Operator op{Operator::kEqual};
+    bool numeric{false};
+    double number{0};
+    std::string text;
+    unsigned int fields{0};  // ProcessField bits the predicate reads
+    int cost{0};             // of the most expensive predicate below
+  };
+  class Parser;
+
+  template <typename Fetch>
+  bool Evaluate(int index, Process& process, Fetch& fetch) const;
+  static bool Test(const Node& node, Process& process);
+
+  std::string text_;
+  std::vector<Node> nodes_;
+  int root_{-1};
+};
+
+template <typename Fetch>
+bool ProcessFilter::Matches(Process& process, Fetch fetch) const {
+  return root_ < 0 || Evaluate(root_, process, fetch);
+}
+
+template <typename Fetch>
+bool ProcessFilter::Evaluate(int index, Process& process, Fetch& fetch) const {
+  const Node& node = nodes_[index];
+  switch (node.kind) {
+    case Kind::kAll:
+      for (int operand : node.operands) {
+        if (!Evaluate(operand, process, fetch)) {
+          return false;
+        }
+      }
+      return true;
+    case Kind::kAny:
+      for (int operand : node.operands) {
+        if (Evaluate(operand, process, fetch)) {
+          return true;
+        }
+      }
+      return false;
+    case Kind::kNot:
+      return !Evaluate(node.operands[0], process, fetch);
+    case Kind::kTest:
+      break;
+  }
+  fetch(node.fields);
+  return Test(node, process);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef PROCESS_STORE_H
+#define PROCESS_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "string_pool.h"
+
+/*
+Values of every process as a struct of arrays, a process is a row index
+into the columns and Process is a view of its row. The counters the
+cpu delta and the sort go over are contiguous arrays of 64 bit
+integers and floats. User, command and cgroup are handles into a
+StringPool shared by every process, one copy per distinct value.
+Rows of different indexes may be written by different threads
+*/
+struct ProcessStore {
+  std::size_t Size() const;
+  // append the row of a process whose files are not read yet
+  std::size_t Add(int pid);
+  // the last row replaces the row of index
+  void Remove(std::size_t index);
+
+  std::vector<int> pid;
+  std::vector<int> ppid;
+  std::vector<long> uid;  // -1 until read, and in a replay
+  std::vector<StringPool::Handle> user;
+  std::vector<StringPool::Handle> command;
+  std::vector<StringPool::Handle> cgroup;
+  std::vector<std::string> comm;  // at most 15 characters, not pooled
+  std::vector<long> start_time;   // jiffies after boot, tells reused PIDs apart
+  std::vector<long> rss_pages;
+  std::vector<long> uptime;
+  std::vector<long> ram_kb;
+  std::vector<long> pss_kb;  // -1 until read
+  std::vector<long> uss_kb;
+  std::vector<long> smaps_ms;  // time of the last smaps_rollup read
+  // counters since the start of the process and of the system, the
+  // deltas of 64 bit integers stay exact at any uptime and cpu count
+  std::vector<uint64_t> cpu_jiffies;
+  std::vector<uint64_t> prev_cpu_jiffies;
+  std::vector<uint64_t> prev_total_jiffies;
+  std::vector<uint64_t> read_bytes;
+  std::vector<uint64_t> write_bytes;
+  std::vector<double> prev_rss_seconds;
+  std::vector<double> prev_io_seconds;  // SystemSnapshot::Seconds()
+  std::vector<float> cpu_utilization;
+  std::vector<float> read_rate;
+  std::vector<float> write_rate;
+  std::vector<float> rss_growth;
+  std::vector<unsigned int> known;  // kUserField, kCommandField, kCgroupField
+  std::vector<unsigned int> stat_tick;
+  std::vector<unsigned int> status_tick;
+  std::vector<unsigned int> io_tick;
+  std::vector<char> state;
+  // bytes rather than vector<bool>, whose bits threads can't write apart
+  std::vector<unsigned char> matched;
+  std::vector<unsigned char> io_denied;  // EACCES, not read again
+
+ private:
+  // call function with every column
+  template <typename Function>
+  void Columns(Function function);
+};
+
+template <typename Function>
+void ProcessStore::Columns(Function function) {
+  function(pid);
+  function(ppid);
+  function(uid);
+  function(user);
+  function(command);
+  function(cgroup);
+  function(comm);
+  function(start_time);
+  function(rss_pages);
+  function(uptime);
+  function(ram_kb);
+  function(pss_kb);
+  function(uss_kb);
+  function(smaps_ms);
+  function(cpu_jiffies);
+  function(prev_cpu_jiffies);
+  function(prev_total_jiffies);
+  function(read_bytes);
+  function(write_bytes);
+  function(prev_rss_seconds);
+  function(prev_io_seconds);
+  function(cpu_utilization);
+  function(read_rate);
+  function(write_rate);
+  function(rss_growth);
+  function(known);
+  function(stat_tick);
+  function(status_tick);
+  function(io_tick);
+  function(state);
+  function(matched);
+  function(io_denied);
+}
+
+#endif
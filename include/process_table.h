@@ -0,0 +1,124 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "process.h"
+#include "process_store.h"
+
+/*
+Processes of the system keyed by PID.
+The values of the processes are the rows of a ProcessStore, and the
+process vector holds a view of every row at its index. An open
+addressing hash index maps a PID to its row, and every Update() stamps
+the processes seen during the tick with a new generation, so births and
+deaths are found in O(N) and no memory is allocated once the table has
+grown to the process count
+*/
+class ProcessTable {
+ public:
+  ProcessTable() = default;
+  // the views point into the table's own store
+  ProcessTable(const ProcessTable&) = delete;
+  ProcessTable& operator=(const ProcessTable&) = delete;
+
+  void Update(const std::vector<int>& pids);
+  // forget every process, like a new table
+  void Clear();
+  std::vector<Process>& Processes();
+  // process of pid, nullptr when the last Update() did not list it
+  Process* Lookup(int pid);
+  // copy the first count processes in the order of compare into top,
+  // the processes are not reordered and only the top rows get sorted.
+  // Processes the filter rejected are left out.
+  // prepare is called on the table's process before it is copied
+  template <typename Compare, typename Prepare>
+  void Top(size_t count, Compare compare, Prepare prepare,
+           std::vector<Process>& top);
+  template <typename Compare>
+  void Top(size_t count, Compare compare, std::vector<Process>& top) {
+    Top(count, compare, [](Process&) {}, top);
+  }
+  // as above in the order of key. The values of a numeric key are read
+  // from their column into pairs with the row, which the sort compares
+  // instead of reaching into the store for every comparison
+  template <typename Prepare>
+  void Top(size_t count, SortKey key, Prepare prepare,
+           std::vector<Process>& top);
+
+ private:
+  struct Slot {
+    int pid{kEmpty};
+    int index{0};
+  };
+  static const int kEmpty{-1};
+
+  size_t Home(int pid) const;
+  size_t Locate(int pid) const;
+  int Find(int pid) const;
+  void Insert(int pid, int index);
+  void Erase(int pid);
+
+  ProcessStore store_;
+  std::vector<Process> processes_;         // view of row i at index i
+  std::vector<unsigned int> generations_;  // parallel to the rows
+  std::vector<Slot> slots_;                // size is a power of two
+  std::vector<int> order_;                 // scratch space of Top()
+  std::vector<std::pair<double, int>> keys_;  // and its sort values
+  unsigned int generation_{0};
+};
+
+// partial sort of positions, O(N log count) instead of O(N log N)
+template <typename Compare, typename Prepare>
+void ProcessTable::Top(size_t count, Compare compare, Prepare prepare,
+                       std::vector<Process>& top) {
+  order_.clear();
+  for (size_t i = 0; i < store_.Size(); ++i) {
+    if (store_.matched[i]) {
+      order_.push_back(i);
+    }
+  }
+  count = std::min(count, order_.size());
+  std::partial_sort(order_.begin(), order_.begin() + count, order_.end(),
+                    [this, &compare](int a, int b) {
+                      return compare(processes_[a], processes_[b]);
+                    });
+  top.clear();
+  for (size_t i = 0; i < count; ++i) {
+    prepare(processes_[order_[i]]);
+    top.push_back(processes_[order_[i]]);
+  }
+}
+
+template <typename Prepare>
+void ProcessTable::Top(size_t count, SortKey key, Prepare prepare,
+                       std::vector<Process>& top) {
+  if (!Process::Numeric(key)) {
+    auto before = [key](const Process& a, const Process& b) {
+      return a.Before(b, key);
+    };
+    Top(count, before, prepare, top);
+    return;
+  }
+  keys_.clear();
+  for (size_t i = 0; i < store_.Size(); ++i) {
+    if (store_.matched[i]) {
+      keys_.emplace_back(processes_[i].SortValue(key), i);
+    }
+  }
+  count = std::min(count, keys_.size());
+  std::partial_sort(keys_.begin(), keys_.begin() + count, keys_.end(),
+                    [](const std::pair<double, int>& a,
+                       const std::pair<double, int>& b) {
+                      return a.first < b.first;
+                    });
+  top.clear();
+  for (size_t i = 0; i < count; ++i) {
+    prepare(processes_[keys_[i].second]);
+    top.push_back(processes_[keys_[i].second]);
+  }
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "process.h"
+
+// A process in tree order, with the sums over its subtree
+struct TreeRow {
+  std::size_t index{0};  // of the process in the vector given to Rows()
+  int depth{0};          // 0 for a root
+  float cpu_utilization{0};  // of the process and all its descendants
+  long rss_kb{0};
+  int descendants{0};
+  bool collapsed{false};  // the descendants are not listed
+};
+
+/*
+Parent/child index of the processes, keyed by PID. Update() only relinks
+the processes which were born, died or got a new parent since the last
+tick, then sums every subtree in one pass from the leaves up. Processes
+whose parent isn't listed, as init, kthreadd or processes whose parent
+lives outside the PID namespace, are roots
+*/
+class ProcessTree {
+ public:
+  // processes need kStatField of the tick, for the parent PID, the cpu
+  // usage and the rss
+  void Update(std::vector<Process>& processes);
+  // the first count rows in tree order, siblings in the order of key, by
+  // their subtree sums for kCpu and kRss. Collapsed PIDs hide their
+  // descendants, and a process is only listed when the filter accepted
+  // it or one of its descendants
+  void Rows(std::vector<Process>& processes, std::size_t count, SortKey key,
+            const std::unordered_set<int>& collapsed,
+            std::vector<TreeRow>& rows);
+  bool Contains(int pid) const;
+
+ private:
+  struct Node {
+    int pid{0};
+    int ppid{0};               // of the last link, as read from stat
+    Node* parent{nullptr};     // nullptr for a root
+    std::vector<Node*> children;
+    std::size_t index{0};      // of the process in the vector
+    unsigned int generation{0};
+    float cpu_utilization{0};  // subtree sums
+    long rss_kb{0};
+    int descendants{0};
+    int matches{0};  // processes of the subtree the filter accepted
+  };
+
+  static void Unlink(Node& node);
+
+  // nodes are never moved, so the links are plain pointers
+  std::unordered_map<int, Node> nodes_;
+  std::vector<Node*> roots_;
+  std::vector<Node*> order_;  // scratch, parents before children
+  std::vector<std::pair<Node*, int>> stack_;  // scratch of Rows()
+  unsigned int generation_{0};
+};
+
+#endif
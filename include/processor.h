@@ -1,12 +1,40 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <cstdint>
+#include <vector>
+
+#include "system_snapshot.h"
+
+// Shares of a cpu's time over the last interval, from 0 to 1
+struct CpuShare {
+  float utilization{0};
+  float user{0};    // user and nice
+  float system{0};  // system, irq and softirq
+  float iowait{0};
+  float steal{0};
+};
+
+/*
+CPU utilization over the interval between two snapshots, for the whole
+system and for every core. The counters of all cpu lines are kept in one
+flat array so the deltas are a single loop the compiler can vectorize
+*/
 class Processor {
  public:
   float Utilization();  // DONE: See src/processor.cpp
+  void Update(const SystemSnapshot& snapshot);
+  int Cores() const;
+  // aggregate share of all cpus
+  const CpuShare& Share() const;
+  const CpuShare& Share(int core) const;
+  const std::vector<CpuShare>& Shares() const;  // index 0 is the aggregate
 
   // DONE: Declare any necessary private members
  private:
+  std::vector<uint64_t> previous_;
+  std::vector<uint64_t> delta_;
+  std::vector<CpuShare> shares_ = std::vector<CpuShare>(1);
 };
 
-#endif
\ No newline at end of file
+#endif
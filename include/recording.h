@@ -0,0 +1,116 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "system_snapshot.h"
+
+// Values of one process in a recorded tick
+struct ProcessRecord {
+  int pid{0};
+  long start_time{0};  // jiffies after boot
+  long cpu_jiffies{0};
+  long rss_kb{0};
+  std::string user;
+  std::string command;
+};
+
+// Everything recorded about one sampling tick
+struct TickRecord {
+  int64_t time_ms{0};  // wall clock
+  SystemSnapshot system;
+  std::vector<ProcessRecord> processes;  // ordered by PID
+};
+
+/*
+Binary recording of ticks. Counters and PIDs are stored as varint
+deltas against the previous tick, every kKeyframeInterval ticks a
+keyframe stores them against zero so a reader can seek. User and
+command strings are interned: a string is written once, in the first
+tick of a keyframe interval using it, and referred to by its index
+afterwards
+*/
+class Recorder {
+ public:
+  static const int kKeyframeInterval{64};
+
+  Recorder() = default;
+  ~Recorder();
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+
+  bool Open(const std::string& path, const std::string& operating_system,
+            const std::string& kernel);
+  // the tick is flushed to the file before returning
+  bool Write(const TickRecord& tick);
+
+ private:
+  struct Previous {
+    long start_time;
+    long cpu_jiffies;
+    long rss_kb;
+  };
+  uint64_t Intern(const std::string& value, std::string& new_strings,
+                  uint64_t& new_count);
+
+  FILE* file_{nullptr};
+  long ticks_{0};
+  std::unordered_map<std::string, uint64_t> strings_;
+  std::unordered_map<int, Previous> previous_;
+  std::vector<uint64_t> previous_counters_;
+  int64_t previous_time_{0};
+  int64_t previous_clock_{0};  // microseconds
+  long previous_uptime_{0};
+  std::string buffer_;
+};
+
+/*
+Read side of a recording. The file is memory mapped and only the tick
+sizes are walked on Open(), ticks and their strings are decoded when
+they are read
+*/
+class Recording {
+ public:
+  Recording() = default;
+  ~Recording();
+  Recording(const Recording&) = delete;
+  Recording& operator=(const Recording&) = delete;
+
+  bool Open(const std::string& path);
+  std::size_t Ticks() const;
+  const std::string& OperatingSystem() const;
+  const std::string& Kernel() const;
+  // sequential reads decode one tick, others decode from the keyframe
+  bool Read(std::size_t index, TickRecord& tick);
+
+ private:
+  struct Previous {
+    long start_time;
+    long cpu_jiffies;
+    long rss_kb;
+  };
+  bool Decode(std::size_t index, TickRecord& tick);
+
+  const unsigned char* data_{nullptr};
+  std::size_t size_{0};
+  std::string operating_system_;
+  std::string kernel_;
+  long keyframe_interval_{Recorder::kKeyframeInterval};
+  std::vector<std::size_t> offsets_;  // payload of every tick
+  std::vector<std::size_t> ends_;     // and its end
+  // decoding state
+  std::vector<std::string> strings_;
+  std::size_t next_{0};
+  std::unordered_map<int, Previous> previous_;
+  std::vector<uint64_t> previous_counters_;
+  int64_t previous_time_{0};
+  int64_t previous_clock_{0};  // microseconds
+  long previous_uptime_{0};
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+Fixed capacity buffer of the latest values, the oldest value is
+overwritten once it is full. Memory is allocated once on construction
+*/
+template <typename T>
+class RingBuffer {
+ public:
+  explicit RingBuffer(std::size_t capacity) : values_(capacity) {}
+
+  void Push(const T& value) {
+    values_[head_] = value;
+    head_ = (head_ + 1) % values_.size();
+    if (size_ < values_.size()) {
+      ++size_;
+    }
+  }
+  std::size_t Size() const { return size_; }
+  std::size_t Capacity() const { return values_.size(); }
+  // index 0 is the oldest value
+  const T& operator[](std::size_t index) const {
+    return values_[(head_ + values_.size() - size_ + index) % values_.size()];
+  }
+
+ private:
+  std::vector<T> values_;
+  std::size_t head_{0};
+  std::size_t size_{0};
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "alerts.h"
+#include "disks.h"
+#include "cgroups.h"
+#include "history.h"
+#include "network.h"
+#include "process.h"
+#include "processor.h"
+#include "self_stats.h"
+#include "system_snapshot.h"
+#include "task_list.h"
+
+// Values of a process row as shown on screen
+struct ProcessSample {
+  int pid{0};
+  std::string user;
+  std::string command;
+  float cpu_utilization{0};
+  long ram_kb{0};
+  long pss_kb{-1};  // -1 when not read
+  long uss_kb{-1};
+  float read_rate{0};  // storage bytes per second
+  float write_rate{0};
+  long uptime{0};
+  std::vector<float> cpu_history;  // latest 1 s points, oldest first
+  bool expanded{false};
+  std::vector<Task> threads;  // busiest first, empty unless read
+  std::size_t thread_count{0};  // threads read, threads holds a few
+  // tree view: depth below a root, and the sums over the subtree
+  int depth{0};
+  float subtree_cpu{0};
+  long subtree_rss_kb{0};
+  int descendants{0};
+  bool collapsed{false};
+  bool alerting{false};  // a process rule fires for it
+};
+
+// seconds summarized by the stats of a Sample
+const long kStatsWindow{600};
+
+/*
+Everything the display needs from one sampling tick. Samples are
+filled by the sampler thread and read-only once published
+*/
+struct Sample {
+  std::string operating_system;
+  std::string kernel;
+  SystemSnapshot system;
+  std::vector<CpuShare> cpu_shares;  // index 0 is the aggregate
+  std::vector<DiskRate> disks;
+  NetworkRates network;
+  std::vector<float> cpu_history;  // latest 1 s points, oldest first
+  std::vector<float> memory_history;
+  SeriesStats cpu_stats;  // over kStatsWindow
+  SeriesStats memory_stats;
+  SortKey sort_key{SortKey::kCpu};
+  long replay_tick{-1};  // -1 when live
+  long replay_ticks{0};
+  int64_t replay_time_ms{0};
+  bool paused{false};
+  SelfStats::Summary self_stats[SelfStats::kStages];
+  std::vector<ProcessSample> processes;  // top rows in display order
+  bool grouped{false};
+  std::vector<CgroupStats> cgroups;  // busiest first, when grouped
+  bool tree{false};  // processes are in tree order
+  std::string filter;  // text of the process filter, empty for none
+  std::vector<Alert> alerts;  // firing, oldest first
+};
+
+#endif
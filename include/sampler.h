@@ -0,0 +1,79 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "process_filter.h"
+#include "sample.h"
+#include "system.h"
+#include "triple_buffer.h"
+
+/*
+Samples the system on a background thread at a fixed rate.
+Ticks are scheduled against deadlines, so the time a tick takes does
+not drift the interval, and every tick publishes a Sample of the top
+processes through a triple buffer which the display reads without locks
+*/
+class Sampler {
+ public:
+  static constexpr std::chrono::milliseconds kMinInterval{100};
+
+  Sampler(System& system, std::chrono::milliseconds interval,
+          std::size_t top_count);
+  ~Sampler();
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  void Start();
+  void Stop();
+  // reader side, true when Latest() changed since the last call
+  bool Update();
+  const Sample& Latest() const;
+  // applied by the sampler thread, which samples again right away
+  void SortBy(SortKey key);
+  // replay only: move by ticks, and stop or resume the replay
+  void Seek(long ticks);
+  void Pause();
+  // show or hide the threads of pid, and of the first count rows
+  void Expand(int pid);
+  void ExpandTop(std::size_t count);
+  // toggle the grouping of the processes by cgroup
+  void GroupByCgroup();
+  // toggle the tree view, and hide or show the descendants of pid
+  void TreeView();
+  void Collapse(int pid);
+  // list only the processes matching filter
+  void FilterBy(const ProcessFilter& filter);
+
+ private:
+  void Run();
+  void Wake();
+  void Fill(Sample& sample);
+
+  System& system_;
+  std::chrono::milliseconds interval_;
+  TripleBuffer<Sample> samples_;
+  std::atomic<SortKey> sort_key_{SortKey::kCpu};
+  std::atomic<long> seek_{0};
+  std::atomic<bool> paused_{false};
+  std::atomic<std::size_t> expand_top_{0};
+  std::atomic<bool> grouped_{false};
+  std::atomic<bool> tree_{false};
+  std::vector<int> expand_;  // PIDs toggled, guarded by mutex_
+  std::vector<int> collapse_;
+  ProcessFilter filter_;  // the next filter when filtered_
+  bool filtered_{false};
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool running_{false};
+  bool woken_{false};
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef SELF_STATS_H
+#define SELF_STATS_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+Cost of the monitor itself. Every stage of a tick is timed and the
+syscalls, bytes read and allocations made meanwhile are counted, the
+last kTicks ticks of every stage are kept for percentiles. The counters
+are kept per thread, so a stage only counts what its own thread did
+while stages run at once on other threads, and process wide for the
+totals. Allocations are counted by the replaced global operator new
+*/
+namespace SelfStats {
+enum Stage { kDiscovery = 0, kParse, kSort, kRender, kStages };
+extern const char* const kStageNames[kStages];
+const int kTicks{600};
+
+struct Counters {
+  uint64_t syscalls{0};
+  uint64_t bytes_read{0};
+  uint64_t allocations{0};
+};
+// totals since the start of the process
+Counters Totals();
+// totals of the calling thread
+Counters ThreadTotals();
+// count what other threads did on behalf of the calling thread, like
+// the workers of a pool, into the stage it has open
+void Credit(const Counters& counters);
+// count syscalls made to read bytes from /proc
+void CountRead(uint64_t syscalls, uint64_t bytes);
+
+// a stage over the last ticks: percentiles of its time in ms and the
+// mean of its counters per tick, and its ticks and time since the start
+struct Summary {
+  long ticks{0};
+  uint64_t count{0};
+  double total_milliseconds{0};
+  double p50{0};
+  double p95{0};
+  double p99{0};
+  double max{0};
+  double syscalls{0};
+  double bytes_read{0};
+  double allocations{0};
+};
+Summary Summarize(Stage stage);
+
+// measures a stage from construction to destruction
+class Timer {
+ public:
+  explicit Timer(Stage stage);
+  ~Timer();
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+
+ private:
+  Stage stage_;
+  std::chrono::steady_clock::time_point start_;
+  Counters counters_;
+};
+};  // namespace SelfStats
+
+#endif
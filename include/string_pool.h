@@ -0,0 +1,45 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+One shared copy of every distinct string in use. Processes share their
+user name and cgroup, and often their command line, so a process holds
+a handle to the pooled copy instead of a string of its own. A string
+leaves the pool when its last handle is dropped, so the commands of
+short lived processes don't pile up. The pool has to outlive its handles
+*/
+class StringPool {
+ public:
+  using Handle = std::shared_ptr<const std::string>;
+
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // the empty string, which isn't pooled
+  static const Handle& Empty();
+  // safe to call from every thread of the pool of workers
+  Handle Intern(std::string_view text);
+  std::size_t Size();
+
+ private:
+  struct Entry {
+    const std::string* string;
+    std::weak_ptr<const std::string> handle;
+  };
+
+  // deleter of the handles
+  void Release(const std::string* string);
+
+  std::mutex mutex_;
+  std::unordered_map<std::string_view, Entry> strings_;  // views the copies
+};
+
+#endif
@@ -1,16 +1,37 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "alerts.h"
+#include "cgroups.h"
+#include "disks.h"
+#include "history.h"
+#include "network.h"
 #include "process.h"
+#include "process_discovery.h"
+#include "process_filter.h"
+#include "process_table.h"
+#include "process_tree.h"
 #include "processor.h"
+#include "recording.h"
+#include "system_snapshot.h"
+#include "task_list.h"
+#include "worker_pool.h"
 
 class System {
  public:
   System();
   Processor& Cpu();                   // DONE: See src/system.cpp
+  const std::vector<DiskRate>& DiskRates() const;
+  const NetworkRates& Traffic() const;
   std::vector<Process>& Processes();  // DONE: See src/system.cpp
   float MemoryUtilization();          // DONE: See src/system.cpp
   long UpTime();                      // DONE: See src/system.cpp
@@ -18,11 +39,116 @@ class System {
   int RunningProcesses();             // DONE: See src/system.cpp
   std::string Kernel();               // DONE: See src/system.cpp
   std::string OperatingSystem();      // DONE: See src/system.cpp
+  const SystemSnapshot& Snapshot() const;
+  // only the processes matching filter are listed by Processes() and
+  // summed by the cgroup view, the others only get the fields the
+  // filter needs read
+  void FilterBy(const ProcessFilter& filter);
+  const ProcessFilter& Filtering() const;
+  // Processes() returns the first count processes in the order of key
+  void SortBy(SortKey key);
+  SortKey SortedBy() const;
+  void TopCount(std::size_t count);
+  // find processes through proc connector events instead of scanning
+  // the proc root every tick, false when the events aren't available
+  bool WatchEvents();
+  // the threads of expanded processes and of the first count rows are
+  // read every tick while they are shown, live only
+  void Expand(int pid, bool expanded);
+  bool Expanded(int pid) const;
+  void ExpandTop(std::size_t count);
+  // threads of a shown process, busiest first, nullptr when not read
+  const std::vector<Task>* Tasks(int pid) const;
+  // group every process by its cgroup each tick, live only
+  void GroupByCgroup(bool grouped);
+  bool GroupedByCgroup() const;
+  const std::vector<CgroupStats>& ControlGroups() const;
+  // Processes() lists the processes as a tree of parents and children,
+  // live only
+  void TreeView(bool tree);
+  bool TreeViewed() const;
+  // hide the descendants of pid in the tree view
+  void Collapse(int pid, bool collapsed);
+  bool Collapsed(int pid) const;
+  // rows of Processes() in the tree view, empty otherwise
+  const std::vector<TreeRow>& TreeRows() const;
+  // threshold rules evaluated by every sampled or replayed tick, false
+  // with a message in error when rule isn't one
+  bool AddAlert(const std::string& rule, std::string& error);
+  const std::vector<Alert>& FiringAlerts() const;
+  // alerts fired or cleared by the last Processes()
+  const std::vector<AlertEvent>& AlertEvents() const;
+  // number of threads sampling the processes, including the caller
+  void Threads(unsigned int threads);
+  // history of the last ticks, queried over the last seconds
+  const History& Trends() const;
+  SeriesStats CpuStats(long seconds) const;
+  SeriesStats CoreStats(int core, long seconds) const;
+  SeriesStats MemoryStats(long seconds) const;
+  SeriesStats ProcessCpuStats(int pid, long seconds) const;
+  SeriesStats ProcessRssStats(int pid, long seconds) const;
+  // every process of the last tick, ordered by PID
+  void Record(TickRecord& tick);
+  // Processes() replays the recording instead of sampling /proc,
+  // false when the recording can't be read
+  bool Replay(const std::string& path);
+  // move the replay by ticks, back when negative
+  void Seek(long ticks);
+  void Pause(bool paused);
+  bool Paused() const;
+  // shown tick of the recording, -1 when live
+  long ReplayTick() const;
+  long ReplayTicks() const;
+  int64_t ReplayTime() const;  // wall clock of the shown tick in ms
 
   // DONE: Define any necessary private members
  private:
   Processor cpu_ = {};
-  std::vector<Process> processes_ = {};
+  Disks disks_ = {};
+  Network network_ = {};
+  Cgroups cgroups_ = {};
+  bool grouped_ = false;
+  ProcessTable processes_ = {};
+  ProcessFilter filter_ = {};
+  std::vector<Process> top_ = {};
+  SortKey sort_key_ = SortKey::kCpu;
+  std::size_t top_count_ = std::numeric_limits<std::size_t>::max();
+  std::unique_ptr<WorkerPool> pool_;
+  ProcessDiscovery discovery_;
+  std::vector<int> execs_ = {};
+  unsigned int tick_count_ = 0;  // sampled ticks, stamps the fetched fields
+  SystemSnapshot snapshot_ = {};
+  History history_ = {};
+  std::chrono::steady_clock::time_point start_ =
+      std::chrono::steady_clock::now();
+
+  // replay state
+  std::unique_ptr<Recording> recording_;
+  TickRecord tick_ = {};
+  long replay_next_ = 0;
+  bool paused_ = false;
+  bool seeked_ = false;
+  std::vector<int> pids_ = {};  // of the tick, sampled or replayed
+
+  // thread view
+  std::unordered_set<int> expanded_ = {};
+  std::size_t expand_top_ = 0;
+  std::unordered_map<int, TaskList> tasks_ = {};
+
+  // tree view
+  ProcessTree tree_ = {};
+  bool tree_view_ = false;
+  std::unordered_set<int> collapsed_ = {};
+  std::vector<TreeRow> tree_rows_ = {};
+
+  Alerts alerts_ = {};
+
+  void Sample();
+  // unmatched: also the processes the filter rejected
+  void Fetch(unsigned int fields, bool unmatched = false);
+  void Match();
+  bool Advance();
+  void ScanTasks();
 
   // attributes which should be fetch one time
   std::string kernel_;
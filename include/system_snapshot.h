@@ -0,0 +1,45 @@
+#ifndef SYSTEM_SNAPSHOT_H
+#define SYSTEM_SNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+System wide values of a single refresh tick.
+It is captured once per tick and then handed to every
+Process::refresh(), so /proc/stat is not re-read per process
+*/
+struct SystemSnapshot {
+  static SystemSnapshot Capture();
+  // the clock of per second rates
+  double Seconds() const;
+
+  // every cpu line of /proc/stat as one flat array of counters, a row
+  // of LinuxParser::kCpuStates per cpu line: row 0 is the aggregate
+  // "cpu" line and row n + 1 is "cpun"
+  std::vector<uint64_t> cpu_jiffies;
+  // CLOCK_BOOTTIME when captured, unlike the cpu counters it keeps
+  // running at the same pace when cpus go offline
+  double clock_seconds{0};
+  int cpu_count{0};
+  long active_jiffies{0};
+  long idle_jiffies{0};
+  long total_jiffies{0};
+  float memory_utilization{0};
+  // kB of /proc/meminfo, not recorded, so 0 in a replay
+  long memory_total_kb{0};
+  long memory_available_kb{0};
+  long buffers_kb{0};
+  long cached_kb{0};
+  long swap_total_kb{0};
+  long swap_free_kb{0};
+  long uptime{0};
+  int total_processes{0};
+  int running_processes{0};
+  std::vector<LinuxParser::Disk> disks;  // not recorded
+  LinuxParser::NetworkCounters network;  // not recorded
+};
+
+#endif
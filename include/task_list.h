@@ -0,0 +1,45 @@
+#ifndef TASK_LIST_H
+#define TASK_LIST_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "system_snapshot.h"
+
+// One thread of a process, the name is its comm
+struct Task {
+  int tid{0};
+  std::string name;
+  char state{'?'};
+  float cpu_utilization{0};
+};
+
+/*
+Threads of one process, read from /proc/[pid]/task/[tid]/stat. Every
+Refresh() reads one stat file per thread, so a System only keeps the
+lists of the processes which are expanded on screen
+*/
+class TaskList {
+ public:
+  explicit TaskList(int pid = 0);
+  // read the threads, busiest first
+  void Refresh(const SystemSnapshot& snapshot);
+  const std::vector<Task>& Tasks() const;
+
+  unsigned int tick{0};  // stamp of the last refresh, set by the owner
+
+ private:
+  struct Previous {
+    long start_time{0};  // tells reused TIDs apart
+    long jiffies{0};
+  };
+
+  int pid_;
+  long prev_total_jiffies_{0};
+  std::unordered_map<int, Previous> previous_;
+  std::vector<int> tids_;
+  std::vector<Task> tasks_;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*
+Lock free hand over of values from one writer thread to one reader thread.
+The writer fills the back buffer and publishes it by swapping it with
+the middle one, the reader swaps the middle buffer with its front buffer
+when a newer value was published. Neither side ever waits and the reader
+always sees the latest complete value
+*/
+template <typename T>
+class TripleBuffer {
+ public:
+  // writer side
+  T& Back() { return buffers_[back_]; }
+  void Publish() {
+    back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+            kIndex;
+  }
+
+  // reader side, true when Front() changed
+  bool Update() {
+    if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+    return true;
+  }
+  const T& Front() const { return buffers_[front_]; }
+
+ private:
+  static const unsigned int kIndex{3};
+  static const unsigned int kFresh{4};
+
+  T buffers_[3];
+  unsigned int back_{0};
+  std::atomic<unsigned int> middle_{1};
+  unsigned int front_{2};
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "self_stats.h"
+
+/*
+Fixed set of threads splitting an index range into chunks.
+Threads claim the next chunk from a shared atomic counter, so a thread
+stuck on a slow /proc read does not hold back the others. The calling
+thread takes part in the work, a pool of one thread runs inline
+*/
+class WorkerPool {
+ public:
+  explicit WorkerPool(unsigned int threads);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  unsigned int Threads() const;
+  // call work(begin, end) for chunks covering [0, count), returns when
+  // every chunk is done. What the workers read and allocate is credited
+  // to the calling thread's SelfStats stage
+  void ParallelFor(std::size_t count, std::size_t chunk,
+                   const std::function<void(std::size_t, std::size_t)>& work);
+
+ private:
+  void Run();
+  void Drain();
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(std::size_t, std::size_t)>* work_{nullptr};
+  std::size_t count_{0};
+  std::size_t chunk_{1};
+  std::atomic<std::size_t> next_{0};
+  unsigned int busy_{0};
+  SelfStats::Counters counters_;  // of the workers during the round
+  unsigned long round_{0};
+  bool stopping_{false};
+};
+
+#endif
@@ -0,0 +1,463 @@
+#include <spawn.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "alerts.h"
+#include "format.h"
+
+extern char** environ;
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace {
+// processes tested by a worker between two claims of the counter
+const size_t kChunk{64};
+// time the running hooks get to finish on exit, and then to terminate
+const std::chrono::milliseconds kHookGrace{1000};
+
+void Trim(string& text) {
+  size_t begin = text.find_first_not_of(' ');
+  size_t end = text.find_last_not_of(' ');
+  text = begin == string::npos ? string() : text.substr(begin, end - begin + 1);
+}
+
+// "30s", "2m" or "5 ticks"
+bool ParseDuration(const string& text, double& seconds, long& ticks) {
+  char* end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  if (end == text.c_str() || value < 0) {
+    return false;
+  }
+  string unit(end);
+  Trim(unit);
+  seconds = 0;
+  ticks = 0;
+  if (unit == "s") {
+    seconds = value;
+  } else if (unit == "m") {
+    seconds = value * 60;
+  } else if (unit == "tick" || unit == "ticks") {
+    ticks = std::max(1L, static_cast<long>(value + 0.5));
+  } else {
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+bool Alerts::Add(const string& text, string& error) {
+  Rule rule;
+  rule.text = text;
+  Trim(rule.text);
+  string body = rule.text;
+  if (body.compare(0, 8, "process ") == 0) {
+    rule.process = true;
+    body.erase(0, 8);
+  }
+  string clear;
+  size_t keyword = body.rfind(" clear ");
+  rule.has_clear = keyword != string::npos;
+  if (rule.has_clear) {
+    clear = body.substr(keyword + 7);
+    body.resize(keyword);
+  }
+  keyword = body.rfind(" for ");
+  if (keyword != string::npos) {
+    if (!ParseDuration(body.substr(keyword + 5), rule.seconds, rule.ticks)) {
+      error = "expected a duration as 30s, 2m or 5 ticks after for";
+      return false;
+    }
+    body.resize(keyword);
+  }
+  if (rule.process) {
+    if (!ProcessFilter::Compile(body, rule.process_when, error) ||
+        (rule.has_clear &&
+         !ProcessFilter::Compile(clear, rule.process_clear, error))) {
+      return false;
+    }
+    if (rule.process_when.Empty() ||
+        (rule.has_clear && rule.process_clear.Empty())) {
+      error = "expected a condition";
+      return false;
+    }
+  } else if (!Parse(body, rule.when) ||
+             (rule.has_clear && !Parse(clear, rule.clear))) {
+    error = "expected cpu, iowait, steal, memory or swap, < <= > or >= and "
+            "a number";
+    return false;
+  }
+  rules_.push_back(std::move(rule));
+  return true;
+}
+
+bool Alerts::Empty() const {
+  return rules_.empty();
+}
+
+const vector<Alert>& Alerts::Firing() const {
+  return firing_;
+}
+
+const vector<AlertEvent>& Alerts::Events() const {
+  return events_;
+}
+
+// "cpu>90", blanks are allowed around the operator
+bool Alerts::Parse(const string& text, Comparison& comparison) {
+  size_t op = text.find_first_of("<>");
+  if (op == string::npos) {
+    return false;
+  }
+  string name = text.substr(0, op);
+  Trim(name);
+  static const std::pair<const char*, Field> kFields[] = {
+      {"cpu", Field::kCpu},
+      {"iowait", Field::kIowait},
+      {"steal", Field::kSteal},
+      {"memory", Field::kMemory},
+      {"swap", Field::kSwap}};
+  auto field = std::find_if(std::begin(kFields), std::end(kFields),
+                            [&name](const std::pair<const char*, Field>& f) {
+                              return name == f.first;
+                            });
+  if (field == std::end(kFields)) {
+    return false;
+  }
+  comparison.field = field->second;
+  bool equal = op + 1 < text.size() && text[op + 1] == '=';
+  if (text[op] == '<') {
+    comparison.op = equal ? Operator::kLessEqual : Operator::kLess;
+  } else {
+    comparison.op = equal ? Operator::kGreaterEqual : Operator::kGreater;
+  }
+  string number = text.substr(op + (equal ? 2 : 1));
+  Trim(number);
+  char* end = nullptr;
+  comparison.number = std::strtod(number.c_str(), &end);
+  return end != number.c_str() && *end == '\0';
+}
+
+bool Alerts::Holds(const Comparison& comparison, const CpuShare& cpu,
+                   const SystemSnapshot& snapshot) {
+  double value = 0;
+  switch (comparison.field) {
+    case Field::kCpu:
+      value = cpu.utilization * 100;
+      break;
+    case Field::kIowait:
+      value = cpu.iowait * 100;
+      break;
+    case Field::kSteal:
+      value = cpu.steal * 100;
+      break;
+    case Field::kMemory:
+      value = snapshot.memory_utilization * 100;
+      break;
+    case Field::kSwap:
+      if (snapshot.swap_total_kb > 0) {
+        value = 100.0 * (snapshot.swap_total_kb - snapshot.swap_free_kb) /
+                snapshot.swap_total_kb;
+      }
+      break;
+  }
+  switch (comparison.op) {
+    case Operator::kLess:
+      return value < comparison.number;
+    case Operator::kLessEqual:
+      return value <= comparison.number;
+    case Operator::kGreater:
+      return value > comparison.number;
+    case Operator::kGreaterEqual:
+      return value >= comparison.number;
+  }
+  return false;
+}
+
+// holds is the condition of a pending track and the clear condition of
+// a firing one, either has to hold for the duration of the rule
+bool Alerts::Step(const Rule& rule, Track& track, bool holds, double now) {
+  if (!holds) {
+    track.ticks = 0;
+    return false;
+  }
+  if (track.ticks++ == 0) {
+    track.since = now;
+  }
+  bool held = rule.ticks > 0 ? track.ticks >= rule.ticks
+                             : now - track.since >= rule.seconds;
+  if (!held) {
+    return false;
+  }
+  track.firing = !track.firing;
+  track.ticks = 0;
+  return true;
+}
+
+void Alerts::Emit(Track& track, bool fired, int64_t now_ms) {
+  if (fired) {
+    track.alert.since_ms = now_ms;
+  }
+  events_.push_back(AlertEvent{track.alert, fired, now_ms});
+}
+
+// the index of the last tick holds unless processes died since
+Process* Alerts::Locate(vector<Process>& processes, int pid, Track& track) {
+  if (track.index >= processes.size() ||
+      processes[track.index].Pid() != pid) {
+    if (!positioned_) {
+      positions_.clear();
+      for (size_t i = 0; i < processes.size(); ++i) {
+        positions_[processes[i].Pid()] = i;
+      }
+      positioned_ = true;
+    }
+    auto position = positions_.find(pid);
+    if (position == positions_.end()) {
+      return nullptr;
+    }
+    track.index = position->second;
+  }
+  Process& process = processes[track.index];
+  return process.StartTime() == track.start_time ? &process : nullptr;
+}
+
+void Alerts::Update(vector<Process>& processes, const CpuShare& cpu,
+                    const SystemSnapshot& snapshot, unsigned int tick,
+                    bool live, int64_t now_ms, WorkerPool& pool) {
+  events_.clear();
+  ++generation_;
+  positioned_ = false;
+  double now = snapshot.Seconds();
+
+  process_rules_.clear();
+  for (size_t r = 0; r < rules_.size(); ++r) {
+    Rule& rule = rules_[r];
+    if (rule.process) {
+      process_rules_.push_back(r);
+      continue;
+    }
+    Track& track = rule.track;
+    bool holds = !track.firing ? Holds(rule.when, cpu, snapshot)
+                 : rule.has_clear ? Holds(rule.clear, cpu, snapshot)
+                                  : !Holds(rule.when, cpu, snapshot);
+    if (Step(rule, track, holds, now)) {
+      track.alert.rule = rule.text;
+      Emit(track, track.firing, now_ms);
+    }
+  }
+
+  // every condition on every process, spread over the pool. The
+  // predicates fetch what they read, cheapest first
+  size_t count = processes.size();
+  holds_.assign(process_rules_.size() * count, 0);
+  auto fetch = [&snapshot, tick, live](Process& process) {
+    return [&process, &snapshot, tick, live](unsigned int fields) {
+      if (live) {
+        process.Fetch(fields, snapshot, tick);
+      }
+    };
+  };
+  pool.ParallelFor(count, kChunk, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t k = 0; k < process_rules_.size(); ++k) {
+        const Rule& rule = rules_[process_rules_[k]];
+        holds_[k * count + i] =
+            rule.process_when.Matches(processes[i], fetch(processes[i]));
+      }
+    }
+  });
+
+  // states only exist for processes whose condition holds or which are
+  // firing, the others cost one test above
+  for (size_t k = 0; k < process_rules_.size(); ++k) {
+    Rule& rule = rules_[process_rules_[k]];
+    const char* holds = holds_.data() + k * count;
+    for (size_t i = 0; i < count; ++i) {
+      if (holds[i] == 0) {
+        continue;
+      }
+      Process& process = processes[i];
+      Track& track = rule.tracks[process.Pid()];
+      if (track.start_time != process.StartTime()) {
+        if (track.firing) {
+          // the PID now belongs to another process
+          Emit(track, false, now_ms);
+        }
+        track = Track();
+        track.start_time = process.StartTime();
+      }
+      track.index = i;
+      track.generation = generation_;
+    }
+    for (auto entry = rule.tracks.begin(); entry != rule.tracks.end();) {
+      int pid = entry->first;
+      Track& track = entry->second;
+      Process* process = Locate(processes, pid, track);
+      bool when = track.generation == generation_;
+      if (process == nullptr || (!track.firing && !when)) {
+        if (track.firing) {
+          Emit(track, false, now_ms);
+        }
+        entry = rule.tracks.erase(entry);
+        continue;
+      }
+      bool holds = !track.firing ? when
+                   : rule.has_clear
+                       ? rule.process_clear.Matches(*process, fetch(*process))
+                       : !when;
+      if (Step(rule, track, holds, now)) {
+        if (track.firing) {
+          track.alert.rule = rule.text;
+          track.alert.pid = pid;
+          track.alert.command =
+              process->Comm().empty() ? process->Command() : process->Comm();
+        }
+        Emit(track, track.firing, now_ms);
+        if (!track.firing) {
+          entry = rule.tracks.erase(entry);
+          continue;
+        }
+      }
+      ++entry;
+    }
+  }
+
+  firing_.clear();
+  for (const Rule& rule : rules_) {
+    if (rule.track.firing) {
+      firing_.push_back(rule.track.alert);
+    }
+    for (const auto& entry : rule.tracks) {
+      if (entry.second.firing) {
+        firing_.push_back(entry.second.alert);
+      }
+    }
+  }
+  std::stable_sort(firing_.begin(), firing_.end(),
+                   [](const Alert& a, const Alert& b) {
+                     return a.since_ms < b.since_ms;
+                   });
+}
+
+// a hung hook doesn't keep the monitor from exiting, the queued hooks
+// are not started anymore
+AlertOutput::~AlertOutput() {
+  Wait(kHookGrace);
+  for (pid_t pid : hooks_) {
+    kill(-pid, SIGTERM);
+  }
+  Wait(kHookGrace);
+  for (pid_t pid : hooks_) {
+    kill(-pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+  if (file_ != nullptr && file_ != stdout) {
+    std::fclose(file_);
+  }
+}
+
+bool AlertOutput::Open(const string& path) {
+  file_ = path.empty() ? stdout : std::fopen(path.c_str(), "a");
+  return file_ != nullptr;
+}
+
+void AlertOutput::Hook(const string& command) {
+  hook_ = command;
+}
+
+void AlertOutput::Write(const vector<AlertEvent>& events) {
+  Reap();
+  for (const AlertEvent& event : events) {
+    if (file_ != nullptr) {
+      const Alert& alert = event.alert;
+      string time = Format::DateTime(event.time_ms / 1000);
+      if (alert.pid > 0) {
+        std::fprintf(file_, "%s %s pid %d %s: %s\n", time.c_str(),
+                     event.fired ? "fired" : "cleared", alert.pid,
+                     alert.command.c_str(), alert.rule.c_str());
+      } else {
+        std::fprintf(file_, "%s %s system: %s\n", time.c_str(),
+                     event.fired ? "fired" : "cleared", alert.rule.c_str());
+      }
+    }
+    if (!hook_.empty()) {
+      if (queued_.size() < kMaxQueued) {
+        queued_.push_back(event);
+      } else {
+        ++dropped_;
+      }
+    }
+  }
+  while (hooks_.size() < kMaxHooks && !queued_.empty()) {
+    Run(queued_.front());
+    queued_.pop_front();
+  }
+  if (file_ != nullptr && dropped_ > 0) {
+    std::fprintf(file_, "%lu alert hooks dropped, %zu queued\n", dropped_,
+                 queued_.size());
+    dropped_ = 0;
+  }
+  if (file_ != nullptr && !events.empty()) {
+    std::fflush(file_);
+  }
+}
+
+// the alert goes into the environment, not into the command line where
+// the shell would interpret it. A hook leads its own process group, so
+// it and the commands it started can be signalled together
+void AlertOutput::Run(const AlertEvent& event) {
+  vector<string> variables = {
+      string("MONITOR_ALERT_STATE=") + (event.fired ? "fired" : "cleared"),
+      "MONITOR_ALERT_RULE=" + event.alert.rule,
+      "MONITOR_ALERT_PID=" + std::to_string(event.alert.pid),
+      "MONITOR_ALERT_COMMAND=" + event.alert.command,
+      "MONITOR_ALERT_TIME=" + std::to_string(event.time_ms / 1000)};
+  vector<char*> environment;
+  for (char** variable = environ; *variable != nullptr; ++variable) {
+    if (std::strncmp(*variable, "MONITOR_ALERT_", 14) != 0) {
+      environment.push_back(*variable);
+    }
+  }
+  for (string& variable : variables) {
+    environment.push_back(&variable[0]);
+  }
+  environment.push_back(nullptr);
+  char shell[] = "/bin/sh";
+  char flag[] = "-c";
+  char* arguments[] = {shell, flag, &hook_[0], nullptr};
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+  posix_spawnattr_setpgroup(&attributes, 0);
+  pid_t pid;
+  if (posix_spawn(&pid, shell, nullptr, &attributes, arguments,
+                  environment.data()) == 0) {
+    hooks_.push_back(pid);
+  }
+  posix_spawnattr_destroy(&attributes);
+}
+
+void AlertOutput::Reap() {
+  hooks_.erase(std::remove_if(hooks_.begin(), hooks_.end(),
+                              [](pid_t pid) {
+                                return waitpid(pid, nullptr, WNOHANG) != 0;
+                              }),
+               hooks_.end());
+}
+
+// reap the hooks until none runs or timeout passed
+void AlertOutput::Wait(std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  Reap();
+  while (!hooks_.empty() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Reap();
+  }
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+
+#include "canvas.h"
+
+namespace {
+// unchanged cells shorter than a cursor movement are sent along with the
+// changed cells around them
+const int kMinimumGap{4};
+// never shown, so every cell differs after a resize
+const chtype kUnknown{~chtype(0)};
+}  // namespace
+
+void Canvas::Resize(int rows, int columns) {
+  rows_ = std::max(0, rows);
+  columns_ = std::max(0, columns);
+  cells_.assign(rows_ * columns_, ' ');
+  shown_.assign(rows_ * columns_, kUnknown);
+}
+
+int Canvas::Rows() const {
+  return rows_;
+}
+
+int Canvas::Columns() const {
+  return columns_;
+}
+
+void Canvas::Clear() {
+  std::fill(cells_.begin(), cells_.end(), chtype(' '));
+}
+
+void Canvas::Put(int row, int column, const char* text, attr_t attributes,
+                 int end) {
+  if (row < 0 || row >= rows_) {
+    return;
+  }
+  end = end < 0 ? columns_ : std::min(end, columns_);
+  chtype* cells = cells_.data() + row * columns_;
+  for (; *text != '\0' && column < end; ++text, ++column) {
+    if (column >= 0) {
+      cells[column] = static_cast<unsigned char>(*text) | attributes;
+    }
+  }
+}
+
+void Canvas::Put(int row, int column, chtype cell) {
+  if (row >= 0 && row < rows_ && column >= 0 && column < columns_) {
+    cells_[row * columns_ + column] = cell;
+  }
+}
+
+void Canvas::Box(int top, int left, int height, int width) {
+  int bottom = top + height - 1;
+  int right = left + width - 1;
+  for (int column = left + 1; column < right; ++column) {
+    Put(top, column, ACS_HLINE);
+    Put(bottom, column, ACS_HLINE);
+  }
+  for (int row = top + 1; row < bottom; ++row) {
+    Put(row, left, ACS_VLINE);
+    Put(row, right, ACS_VLINE);
+  }
+  Put(top, left, ACS_ULCORNER);
+  Put(top, right, ACS_URCORNER);
+  Put(bottom, left, ACS_LLCORNER);
+  Put(bottom, right, ACS_LRCORNER);
+}
+
+bool Canvas::Flush(WINDOW* window) {
+  bool changed = false;
+  for (int row = 0; row < rows_; ++row) {
+    chtype* cells = cells_.data() + row * columns_;
+    chtype* shown = shown_.data() + row * columns_;
+    int column = 0;
+    while (column < columns_) {
+      if (cells[column] == shown[column]) {
+        ++column;
+        continue;
+      }
+      // a span ends at kMinimumGap unchanged cells in a row
+      int start = column;
+      int end = column + 1;
+      for (int gap = 0; column < columns_ && gap < kMinimumGap; ++column) {
+        if (cells[column] != shown[column]) {
+          end = column + 1;
+          gap = 0;
+        } else {
+          ++gap;
+        }
+      }
+      mvwaddchnstr(window, row, start, cells + start, end - start);
+      std::copy(cells + start, cells + end, shown + start);
+      column = end;
+      changed = true;
+    }
+  }
+  return changed;
+}
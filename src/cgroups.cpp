@@ -0,0 +1,113 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+
+#include "cgroups.h"
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+// "some avg10=1.23 avg60=..." of a pressure file
+float Pressure(string_view text) {
+  string_view some = ProcReader::FindKey(text, "some");
+  size_t value = some.find("avg10=");
+  if (value == string_view::npos) {
+    return -1;
+  }
+  return std::strtof(some.data() + value + 6, nullptr);
+}
+}  // namespace
+
+Cgroups::Cgroups() : root_(LinuxParser::kCgroupPath) {
+  if (access((root_ + "/cgroup.controllers").c_str(), F_OK) != 0) {
+    root_ += "/unified";
+  }
+}
+
+void Cgroups::Update(vector<Process>& processes,
+                     const SystemSnapshot& snapshot) {
+  index_.clear();
+  groups_.clear();
+  for (Process& process : processes) {
+    // an empty cgroup wasn't read, it is not the root's
+    if (!process.Matched() || process.Cgroup().empty()) {
+      continue;
+    }
+    auto inserted = index_.emplace(process.Cgroup(), groups_.size());
+    if (inserted.second) {
+      groups_.emplace_back();
+      groups_.back().path = process.Cgroup();
+    }
+    CgroupStats& group = groups_[inserted.first->second];
+    ++group.processes;
+    group.cpu_utilization += process.CpuUtilization();
+    group.memory_kb += process.RssKb();
+  }
+  for (CgroupStats& group : groups_) {
+    Read(group, snapshot);
+  }
+  // groups without processes are forgotten
+  for (auto previous = previous_.begin(); previous != previous_.end();) {
+    previous = index_.count(previous->first) == 0 ? previous_.erase(previous)
+                                                  : std::next(previous);
+  }
+  std::sort(groups_.begin(), groups_.end(),
+            [](const CgroupStats& a, const CgroupStats& b) {
+              return a.cpu_utilization > b.cpu_utilization;
+            });
+}
+
+// the cpu usage is over the seconds of the snapshots like the rates of
+// processes, usage_usec counts the time of every cpu. The first tick of
+// a group keeps the sum of its processes
+void Cgroups::Read(CgroupStats& group, const SystemSnapshot& snapshot) {
+  char path[512];
+  auto read = [this, &group, &path](const char* file) {
+    std::snprintf(path, sizeof(path), "%s%s/%s", root_.c_str(),
+                  group.path == "/" ? "" : group.path.c_str(), file);
+    return ProcReader::ReadPath(path);
+  };
+
+  // the root's cpu.stat counts the whole system, not its own processes
+  string_view text = group.path == "/" ? string_view() : read("cpu.stat");
+  if (!text.empty()) {
+    Previous now;
+    now.usage_usec = ProcReader::ValueByKey(text, "usage_usec");
+    now.periods = ProcReader::ValueByKey(text, "nr_periods");
+    now.throttled = ProcReader::ValueByKey(text, "nr_throttled");
+    now.seconds = snapshot.Seconds();
+    auto previous = previous_.find(group.path);
+    if (previous != previous_.end()) {
+      const Previous& before = previous->second;
+      double seconds = now.seconds - before.seconds;
+      group.cpu_utilization =
+          seconds > 0 && now.usage_usec >= before.usage_usec
+              ? (now.usage_usec - before.usage_usec) / 1e6 / seconds /
+                    std::max(1, snapshot.cpu_count)
+              : 0;
+      if (now.periods > before.periods) {
+        group.throttled = float(now.throttled - before.throttled) /
+                          (now.periods - before.periods);
+      }
+    }
+    previous_[group.path] = now;
+  }
+  long memory = 0;
+  text = read("memory.current");
+  if (ProcReader::ScanLong(text, memory)) {
+    group.memory_kb = memory / 1024;
+  }
+  group.cpu_pressure = Pressure(read("cpu.pressure"));
+  group.memory_pressure = Pressure(read("memory.pressure"));
+  group.io_pressure = Pressure(read("io.pressure"));
+}
+
+const vector<CgroupStats>& Cgroups::Groups() const {
+  return groups_;
+}
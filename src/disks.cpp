@@ -0,0 +1,50 @@
+#include <algorithm>
+
+#include "disks.h"
+
+using std::vector;
+
+namespace {
+const double kSectorBytes{512};
+
+double Delta(uint64_t now, uint64_t before) {
+  return now > before ? double(now - before) : 0;
+}
+}  // namespace
+
+void Disks::Update(const SystemSnapshot& snapshot) {
+  double seconds = snapshot.Seconds() - previous_seconds_;
+  previous_seconds_ = snapshot.Seconds();
+  rates_.resize(snapshot.disks.size());
+  for (size_t i = 0; i < snapshot.disks.size(); ++i) {
+    const LinuxParser::Disk& disk = snapshot.disks[i];
+    DiskRate& rate = rates_[i];
+    rate.name = disk.name;
+    // the order of the lines is stable, so the previous line of a device
+    // is usually at the same index
+    auto before = i < previous_.size() && previous_[i].name == disk.name
+                      ? previous_.begin() + i
+                      : std::find_if(previous_.begin(), previous_.end(),
+                                     [&disk](const LinuxParser::Disk& other) {
+                                       return other.name == disk.name;
+                                     });
+    if (before == previous_.end() || seconds <= 0) {
+      rate = DiskRate{disk.name};
+      continue;
+    }
+    rate.read_bytes =
+        Delta(disk.read_sectors, before->read_sectors) * kSectorBytes / seconds;
+    rate.write_bytes = Delta(disk.write_sectors, before->write_sectors) *
+                       kSectorBytes / seconds;
+    rate.iops = (Delta(disk.reads, before->reads) +
+                 Delta(disk.writes, before->writes)) /
+                seconds;
+    rate.utilization = std::min(
+        1.0, Delta(disk.io_ms, before->io_ms) / 1000 / seconds);
+  }
+  previous_ = snapshot.disks;
+}
+
+const vector<DiskRate>& Disks::Rates() const {
+  return rates_;
+}
@@ -0,0 +1,724 @@
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "exporter.h"
+#include "linux_parser.h"
+#include "self_stats.h"
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace {
+// clients served at the same time, others wait in the listen backlog
+const size_t kMaxClients{256};
+// longest request accepted, only the request line is used
+const size_t kMaxRequest{8192};
+// a client has this long to send its request, and a response is dropped
+// once the client read nothing for as long, so idle connections can't
+// hold every slot
+const std::chrono::milliseconds kClientTimeout{5000};
+
+// the cpu modes exported, guest time is already part of user time
+const char* const kCpuModes[] = {"user",   "nice", "system",  "idle",
+                                 "iowait", "irq",  "softirq", "steal"};
+
+string Http(const char* status, const char* type, const string& body) {
+  char header[160];
+  std::snprintf(header, sizeof(header),
+                "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                "Connection: close\r\n\r\n",
+                status, type, body.size());
+  return header + body;
+}
+
+void Append(string& out, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void Append(string& out, const char* format, ...) {
+  char buffer[256];
+  va_list arguments;
+  va_start(arguments, format);
+  int length = std::vsnprintf(buffer, sizeof(buffer), format, arguments);
+  va_end(arguments);
+  if (length > 0) {
+    out.append(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+  }
+}
+
+// label values escape backslash, quote and newline, they are appended
+// as is since Append() is limited to short lines
+void AppendLabel(string& out, const string& value) {
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+}
+
+void AppendJson(string& out, const string& value) {
+  out += '"';
+  for (unsigned char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c < 0x20) {
+      Append(out, "\\u%04x", c);
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+void Metric(string& out, const char* name, const char* type,
+            const char* help) {
+  Append(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+struct Client {
+  int fd;
+  std::chrono::steady_clock::time_point accepted;
+  std::chrono::steady_clock::time_point active;  // last bytes sent
+  string request;
+  std::shared_ptr<const void> keep;  // holds the responses being sent
+  const string* response{nullptr};
+  size_t written{0};
+
+  // end of the request or of the wait for the client to read
+  std::chrono::steady_clock::time_point Deadline() const {
+    return (response == nullptr ? accepted : active) + kClientTimeout;
+  }
+};
+}  // namespace
+
+Exporter::~Exporter() {
+  if (thread_.joinable()) {
+    uint64_t one = 1;
+    if (write(wake_, &one, sizeof(one)) == sizeof(one)) {
+      thread_.join();
+    } else {
+      thread_.detach();
+    }
+  }
+  if (wake_ >= 0) {
+    close(wake_);
+  }
+  if (listener_ >= 0) {
+    close(listener_);
+  }
+  if (!socket_path_.empty()) {
+    unlink(socket_path_.c_str());
+  }
+}
+
+bool Exporter::Listen(const string& address) {
+  if (address.find('/') != string::npos) {
+    sockaddr_un unix_address{};
+    unix_address.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(unix_address.sun_path)) {
+      errno = ENAMETOOLONG;
+      return false;
+    }
+    std::memcpy(unix_address.sun_path, address.c_str(), address.size());
+    listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener_ < 0) {
+      return false;
+    }
+    // a socket left behind by an earlier run is replaced
+    struct stat info;
+    if (lstat(address.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+      unlink(address.c_str());
+    }
+    if (bind(listener_, reinterpret_cast<sockaddr*>(&unix_address),
+             sizeof(unix_address)) != 0) {
+      return false;
+    }
+    socket_path_ = address;
+  } else {
+    char* end = nullptr;
+    long port = std::strtol(address.c_str(), &end, 10);
+    if (end == address.c_str() || *end != '\0' || port <= 0 || port > 65535) {
+      errno = EINVAL;
+      return false;
+    }
+    sockaddr_in inet_address{};
+    inet_address.sin_family = AF_INET;
+    inet_address.sin_port = htons(port);
+    inet_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listener_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener_ < 0) {
+      return false;
+    }
+    int reuse = 1;
+    setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listener_, reinterpret_cast<sockaddr*>(&inet_address),
+             sizeof(inet_address)) != 0) {
+      return false;
+    }
+  }
+  if (listen(listener_, 64) != 0) {
+    return false;
+  }
+  wake_ = eventfd(0, EFD_CLOEXEC);
+  if (wake_ < 0) {
+    return false;
+  }
+  thread_ = std::thread(&Exporter::Serve, this);
+  return true;
+}
+
+std::shared_ptr<const Exporter::Responses> Exporter::Latest() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return responses_;
+}
+
+void Exporter::Publish(System& system, vector<Process>& processes) {
+  static const double ticks = sysconf(_SC_CLK_TCK);
+  SelfStats::Timer timer(SelfStats::kRender);
+  SelfStats::Summary stats[SelfStats::kStages];
+  for (int stage = 0; stage < SelfStats::kStages; ++stage) {
+    stats[stage] = SelfStats::Summarize(static_cast<SelfStats::Stage>(stage));
+  }
+  SelfStats::Counters totals = SelfStats::Totals();
+  const SystemSnapshot& snapshot = system.Snapshot();
+  const vector<CpuShare>& shares = system.Cpu().Shares();
+  long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+
+  string metrics;
+  Metric(metrics, "monitor_cpu_utilization", "gauge",
+         "Busy share of the cpu over the last tick.");
+  for (size_t cpu = 0; cpu < shares.size(); ++cpu) {
+    if (cpu == 0) {
+      Append(metrics, "monitor_cpu_utilization{cpu=\"all\"} %.4f\n",
+             shares[cpu].utilization);
+    } else {
+      Append(metrics, "monitor_cpu_utilization{cpu=\"%zu\"} %.4f\n", cpu - 1,
+             shares[cpu].utilization);
+    }
+  }
+  Metric(metrics, "monitor_cpu_seconds_total", "counter",
+         "Seconds the cpus spent in each mode.");
+  size_t rows = snapshot.cpu_jiffies.size() / LinuxParser::kCpuStates;
+  for (size_t row = 0; row < rows; ++row) {
+    const uint64_t* jiffies =
+        snapshot.cpu_jiffies.data() + row * LinuxParser::kCpuStates;
+    for (size_t mode = 0; mode < sizeof(kCpuModes) / sizeof(*kCpuModes);
+         ++mode) {
+      if (row == 0) {
+        Append(metrics, "monitor_cpu_seconds_total{cpu=\"all\",mode=\"%s\"}",
+               kCpuModes[mode]);
+      } else {
+        Append(metrics, "monitor_cpu_seconds_total{cpu=\"%zu\",mode=\"%s\"}",
+               row - 1, kCpuModes[mode]);
+      }
+      Append(metrics, " %.2f\n", jiffies[mode] / ticks);
+    }
+  }
+  Metric(metrics, "monitor_memory_utilization", "gauge",
+         "Share of the memory in use.");
+  Append(metrics, "monitor_memory_utilization %.4f\n",
+         snapshot.memory_utilization);
+  Metric(metrics, "monitor_memory_bytes", "gauge",
+         "Memory of /proc/meminfo by kind.");
+  const std::pair<const char*, long> memory[] = {
+      {"total", snapshot.memory_total_kb},
+      {"available", snapshot.memory_available_kb},
+      {"buffers", snapshot.buffers_kb},
+      {"cached", snapshot.cached_kb},
+      {"swap_total", snapshot.swap_total_kb},
+      {"swap_free", snapshot.swap_free_kb}};
+  for (const auto& kind : memory) {
+    Append(metrics, "monitor_memory_bytes{kind=\"%s\"} %ld\n", kind.first,
+           kind.second * 1024);
+  }
+  // counters since boot, rates are left to the queries
+  Metric(metrics, "monitor_disk_read_bytes_total", "counter",
+         "Bytes read from the block device.");
+  for (const LinuxParser::Disk& disk : snapshot.disks) {
+    Append(metrics, "monitor_disk_read_bytes_total{device=\"%s\"} %llu\n",
+           disk.name.c_str(),
+           static_cast<unsigned long long>(disk.read_sectors * 512));
+  }
+  Metric(metrics, "monitor_disk_written_bytes_total", "counter",
+         "Bytes written to the block device.");
+  for (const LinuxParser::Disk& disk : snapshot.disks) {
+    Append(metrics, "monitor_disk_written_bytes_total{device=\"%s\"} %llu\n",
+           disk.name.c_str(),
+           static_cast<unsigned long long>(disk.write_sectors * 512));
+  }
+  Metric(metrics, "monitor_disk_io_time_seconds_total", "counter",
+         "Seconds the block device had requests in flight.");
+  for (const LinuxParser::Disk& disk : snapshot.disks) {
+    Append(metrics, "monitor_disk_io_time_seconds_total{device=\"%s\"} %.3f\n",
+           disk.name.c_str(), disk.io_ms / 1000.0);
+  }
+  const LinuxParser::NetworkCounters& network = snapshot.network;
+  const std::pair<const char*, uint64_t LinuxParser::InterfaceCounters::*>
+      interface_counters[] = {
+          {"monitor_network_receive_bytes_total",
+           &LinuxParser::InterfaceCounters::rx_bytes},
+          {"monitor_network_receive_packets_total",
+           &LinuxParser::InterfaceCounters::rx_packets},
+          {"monitor_network_receive_errors_total",
+           &LinuxParser::InterfaceCounters::rx_errors},
+          {"monitor_network_receive_drops_total",
+           &LinuxParser::InterfaceCounters::rx_drops},
+          {"monitor_network_transmit_bytes_total",
+           &LinuxParser::InterfaceCounters::tx_bytes},
+          {"monitor_network_transmit_packets_total",
+           &LinuxParser::InterfaceCounters::tx_packets},
+          {"monitor_network_transmit_errors_total",
+           &LinuxParser::InterfaceCounters::tx_errors},
+          {"monitor_network_transmit_drops_total",
+           &LinuxParser::InterfaceCounters::tx_drops}};
+  for (const auto& counter : interface_counters) {
+    Metric(metrics, counter.first, "counter",
+           "Counter of the network interface, from /proc/net/dev.");
+    for (size_t i = 0; i < network.count; ++i) {
+      const LinuxParser::InterfaceCounters& interface = network.interfaces[i];
+      metrics += counter.first;
+      metrics += "{interface=\"";
+      AppendLabel(metrics, interface.name.data());
+      Append(metrics, "\"} %llu\n",
+             static_cast<unsigned long long>(interface.*counter.second));
+    }
+  }
+  Metric(metrics, "monitor_network_interfaces_hidden", "gauge",
+         "Interfaces matching --interfaces past the ones exported.");
+  Append(metrics, "monitor_network_interfaces_hidden %zu\n", network.hidden);
+  Metric(metrics, "monitor_tcp_segments_total", "counter",
+         "TCP segments received and sent.");
+  Append(metrics, "monitor_tcp_segments_total{direction=\"in\"} %llu\n",
+         static_cast<unsigned long long>(network.tcp_in_segments));
+  Append(metrics, "monitor_tcp_segments_total{direction=\"out\"} %llu\n",
+         static_cast<unsigned long long>(network.tcp_out_segments));
+  Metric(metrics, "monitor_tcp_retransmitted_segments_total", "counter",
+         "TCP segments sent again.");
+  Append(metrics, "monitor_tcp_retransmitted_segments_total %llu\n",
+         static_cast<unsigned long long>(network.tcp_retransmits));
+  Metric(metrics, "monitor_uptime_seconds", "gauge",
+         "Seconds since the system booted.");
+  Append(metrics, "monitor_uptime_seconds %ld\n", snapshot.uptime);
+  Metric(metrics, "monitor_processes_created_total", "counter",
+         "Processes created since boot.");
+  Append(metrics, "monitor_processes_created_total %d\n",
+         snapshot.total_processes);
+  Metric(metrics, "monitor_processes_running", "gauge",
+         "Processes in the runnable state.");
+  Append(metrics, "monitor_processes_running %d\n",
+         snapshot.running_processes);
+
+  // the labels of a process row are the same for all its metrics
+  vector<string> labels(processes.size());
+  for (size_t i = 0; i < processes.size(); ++i) {
+    string& label = labels[i];
+    Append(label, "{pid=\"%d\",user=\"", processes[i].Pid());
+    AppendLabel(label, processes[i].User());
+    label += "\",command=\"";
+    AppendLabel(label, processes[i].Command());
+    label += "\"}";
+  }
+  Metric(metrics, "monitor_process_cpu_utilization", "gauge",
+         "Share of the total cpu time used by the process over the last "
+         "tick.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    metrics += "monitor_process_cpu_utilization";
+    metrics += labels[i];
+    Append(metrics, " %.4f\n", processes[i].CpuUtilization());
+  }
+  Metric(metrics, "monitor_process_resident_bytes", "gauge",
+         "Resident set size of the process.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    metrics += "monitor_process_resident_bytes";
+    metrics += labels[i];
+    Append(metrics, " %ld\n", processes[i].RssKb() * 1024);
+  }
+  // smaps_rollup is only read for some rows, the others have no sample
+  Metric(metrics, "monitor_process_pss_bytes", "gauge",
+         "Proportional set size of the process, shared pages split between "
+         "their users.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    if (processes[i].PssKb() >= 0) {
+      metrics += "monitor_process_pss_bytes";
+      metrics += labels[i];
+      Append(metrics, " %ld\n", processes[i].PssKb() * 1024);
+    }
+  }
+  Metric(metrics, "monitor_process_uss_bytes", "gauge",
+         "Unique set size of the process, the pages no other process maps.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    if (processes[i].UssKb() >= 0) {
+      metrics += "monitor_process_uss_bytes";
+      metrics += labels[i];
+      Append(metrics, " %ld\n", processes[i].UssKb() * 1024);
+    }
+  }
+  Metric(metrics, "monitor_process_read_bytes_total", "counter",
+         "Bytes the process caused to be read from storage.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    metrics += "monitor_process_read_bytes_total";
+    metrics += labels[i];
+    Append(metrics, " %ld\n", processes[i].ReadBytes());
+  }
+  Metric(metrics, "monitor_process_written_bytes_total", "counter",
+         "Bytes the process caused to be written to storage.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    metrics += "monitor_process_written_bytes_total";
+    metrics += labels[i];
+    Append(metrics, " %ld\n", processes[i].WriteBytes());
+  }
+  Metric(metrics, "monitor_process_uptime_seconds", "gauge",
+         "Seconds since the process started.");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    metrics += "monitor_process_uptime_seconds";
+    metrics += labels[i];
+    Append(metrics, " %ld\n", processes[i].UpTime());
+  }
+
+  // cgroups, the gauges of a group without the file are left out
+  const vector<CgroupStats>& groups = system.ControlGroups();
+  vector<string> cgroup_labels(groups.size());
+  for (size_t i = 0; i < groups.size(); ++i) {
+    cgroup_labels[i] = "{cgroup=\"";
+    AppendLabel(cgroup_labels[i], groups[i].path);
+    cgroup_labels[i] += "\"";
+  }
+  auto cgroup_gauge = [&](const char* name, const char* help,
+                          float CgroupStats::*value, double scale,
+                          const char* resource) {
+    Metric(metrics, name, "gauge", help);
+    for (size_t i = 0; i < groups.size(); ++i) {
+      if (groups[i].*value < 0) {
+        continue;
+      }
+      metrics += name;
+      metrics += cgroup_labels[i];
+      if (resource != nullptr) {
+        Append(metrics, ",resource=\"%s\"", resource);
+      }
+      Append(metrics, "} %.4f\n", groups[i].*value * scale);
+    }
+  };
+  Metric(metrics, "monitor_cgroup_processes", "gauge",
+         "Processes of the cgroup.");
+  for (size_t i = 0; i < groups.size(); ++i) {
+    metrics += "monitor_cgroup_processes";
+    metrics += cgroup_labels[i];
+    Append(metrics, "} %d\n", groups[i].processes);
+  }
+  Metric(metrics, "monitor_cgroup_memory_bytes", "gauge",
+         "memory.current of the cgroup, the RSS sum of its processes "
+         "without it.");
+  for (size_t i = 0; i < groups.size(); ++i) {
+    metrics += "monitor_cgroup_memory_bytes";
+    metrics += cgroup_labels[i];
+    Append(metrics, "} %ld\n", groups[i].memory_kb * 1024);
+  }
+  cgroup_gauge("monitor_cgroup_cpu_utilization",
+               "Share of all cpus used by the cgroup over the last tick.",
+               &CgroupStats::cpu_utilization, 1, nullptr);
+  cgroup_gauge("monitor_cgroup_throttled_ratio",
+               "Share of the cpu periods of the last tick the cgroup was "
+               "throttled.",
+               &CgroupStats::throttled, 1, nullptr);
+  // one metric with a resource label, as node_exporter does
+  Metric(metrics, "monitor_cgroup_pressure_ratio", "gauge",
+         "Share of the last 10 s some task of the cgroup stalled.");
+  const std::pair<const char*, float CgroupStats::*> pressures[] = {
+      {"cpu", &CgroupStats::cpu_pressure},
+      {"memory", &CgroupStats::memory_pressure},
+      {"io", &CgroupStats::io_pressure}};
+  for (const auto& pressure : pressures) {
+    for (size_t i = 0; i < groups.size(); ++i) {
+      if (groups[i].*pressure.second < 0) {
+        continue;
+      }
+      metrics += "monitor_cgroup_pressure_ratio";
+      metrics += cgroup_labels[i];
+      Append(metrics, ",resource=\"%s\"} %.4f\n", pressure.first,
+             groups[i].*pressure.second / 100);
+    }
+  }
+
+  // the monitor's own cost, render is the serialization of the responses
+  Metric(metrics, "monitor_self_stage_milliseconds", "summary",
+         "Time of a stage of the monitor's tick.");
+  for (int stage = 0; stage < SelfStats::kStages; ++stage) {
+    const char* name = SelfStats::kStageNames[stage];
+    const SelfStats::Summary& summary = stats[stage];
+    Append(metrics,
+           "monitor_self_stage_milliseconds{stage=\"%s\",quantile=\"0.5\"} "
+           "%.3f\n",
+           name, summary.p50);
+    Append(metrics,
+           "monitor_self_stage_milliseconds{stage=\"%s\",quantile=\"0.95\"} "
+           "%.3f\n",
+           name, summary.p95);
+    Append(metrics,
+           "monitor_self_stage_milliseconds{stage=\"%s\",quantile=\"0.99\"} "
+           "%.3f\n",
+           name, summary.p99);
+    // the quantiles cover the last ticks, sum and count every tick
+    Append(metrics, "monitor_self_stage_milliseconds_sum{stage=\"%s\"} %.3f\n",
+           name, summary.total_milliseconds);
+    Append(metrics,
+           "monitor_self_stage_milliseconds_count{stage=\"%s\"} %llu\n", name,
+           static_cast<unsigned long long>(summary.count));
+  }
+  Metric(metrics, "monitor_self_syscalls_total", "counter",
+         "Syscalls made to read /proc.");
+  Append(metrics, "monitor_self_syscalls_total %llu\n",
+         static_cast<unsigned long long>(totals.syscalls));
+  Metric(metrics, "monitor_self_read_bytes_total", "counter",
+         "Bytes read from /proc.");
+  Append(metrics, "monitor_self_read_bytes_total %llu\n",
+         static_cast<unsigned long long>(totals.bytes_read));
+  Metric(metrics, "monitor_self_allocations_total", "counter",
+         "Heap allocations of the monitor.");
+  Append(metrics, "monitor_self_allocations_total %llu\n",
+         static_cast<unsigned long long>(totals.allocations));
+
+  string json;
+  Append(json,
+         "{\"time_ms\":%lld,\"uptime\":%ld,\"memory_utilization\":%.4f,"
+         "\"processes_created\":%d,\"processes_running\":%d,",
+         now, snapshot.uptime, snapshot.memory_utilization,
+         snapshot.total_processes, snapshot.running_processes);
+  Append(json,
+         "\"memory_kb\":{\"total\":%ld,\"available\":%ld,\"buffers\":%ld,"
+         "\"cached\":%ld,\"swap_total\":%ld,\"swap_free\":%ld},\"cpus\":[",
+         snapshot.memory_total_kb, snapshot.memory_available_kb,
+         snapshot.buffers_kb, snapshot.cached_kb, snapshot.swap_total_kb,
+         snapshot.swap_free_kb);
+  for (size_t cpu = 0; cpu < shares.size(); ++cpu) {
+    const CpuShare& share = shares[cpu];
+    Append(json,
+           "%s{\"utilization\":%.4f,\"user\":%.4f,\"system\":%.4f,"
+           "\"iowait\":%.4f,\"steal\":%.4f}",
+           cpu == 0 ? "" : ",", share.utilization, share.user, share.system,
+           share.iowait, share.steal);
+  }
+  json += "],\"disks\":[";
+  const vector<DiskRate>& disks = system.DiskRates();
+  for (size_t i = 0; i < disks.size(); ++i) {
+    Append(json, "%s{\"device\":", i == 0 ? "" : ",");
+    AppendJson(json, disks[i].name);
+    Append(json,
+           ",\"read_bytes_per_s\":%.0f,\"write_bytes_per_s\":%.0f,"
+           "\"iops\":%.1f,\"utilization\":%.4f}",
+           disks[i].read_bytes, disks[i].write_bytes, disks[i].iops,
+           disks[i].utilization);
+  }
+  const NetworkRates& traffic = system.Traffic();
+  json += "],\"interfaces\":[";
+  for (size_t i = 0; i < traffic.count; ++i) {
+    const InterfaceRate& rate = traffic.interfaces[i];
+    Append(json, "%s{\"interface\":", i == 0 ? "" : ",");
+    AppendJson(json, rate.name.data());
+    Append(json,
+           ",\"rx_bytes_per_s\":%.0f,"
+           "\"tx_bytes_per_s\":%.0f,\"rx_packets_per_s\":%.1f,"
+           "\"tx_packets_per_s\":%.1f,\"errors_per_s\":%.1f,"
+           "\"drops_per_s\":%.1f}",
+           rate.rx_bytes, rate.tx_bytes,
+           rate.rx_packets, rate.tx_packets, rate.errors, rate.drops);
+  }
+  Append(json,
+         "],\"tcp\":{\"in_segments_per_s\":%.1f,\"out_segments_per_s\":%.1f,"
+         "\"retransmits_per_s\":%.1f}",
+         traffic.tcp_in_segments, traffic.tcp_out_segments,
+         traffic.tcp_retransmits);
+  json += ",\"cgroups\":[";
+  for (size_t i = 0; i < groups.size(); ++i) {
+    const CgroupStats& group = groups[i];
+    Append(json, "%s{\"cgroup\":", i == 0 ? "" : ",");
+    AppendJson(json, group.path);
+    // -1 when the cgroup has no such file
+    Append(json,
+           ",\"processes\":%d,\"cpu_utilization\":%.4f,\"throttled\":%.4f,"
+           "\"memory_kb\":%ld,\"cpu_pressure\":%.2f,"
+           "\"memory_pressure\":%.2f,\"io_pressure\":%.2f}",
+           group.processes, group.cpu_utilization, group.throttled,
+           group.memory_kb, group.cpu_pressure, group.memory_pressure,
+           group.io_pressure);
+  }
+  json += "],\"processes\":[";
+  for (size_t i = 0; i < processes.size(); ++i) {
+    Append(json, "%s{\"pid\":%d,\"user\":", i == 0 ? "" : ",",
+           processes[i].Pid());
+    AppendJson(json, processes[i].User());
+    json += ",\"command\":";
+    AppendJson(json, processes[i].Command());
+    Append(json,
+           ",\"cpu_utilization\":%.4f,\"rss_kb\":%ld,\"pss_kb\":%ld,"
+           "\"uss_kb\":%ld,\"read_bytes_per_s\":%.0f,"
+           "\"write_bytes_per_s\":%.0f,\"uptime\":%ld}",
+           processes[i].CpuUtilization(), processes[i].RssKb(),
+           processes[i].PssKb(), processes[i].UssKb(), processes[i].ReadRate(),
+           processes[i].WriteRate(), processes[i].UpTime());
+  }
+  json += "],\"self\":[";
+  for (int stage = 0; stage < SelfStats::kStages; ++stage) {
+    const SelfStats::Summary& summary = stats[stage];
+    Append(json,
+           "%s{\"stage\":\"%s\",\"ticks\":%ld,\"p50_ms\":%.3f,"
+           "\"p95_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,",
+           stage == 0 ? "" : ",", SelfStats::kStageNames[stage], summary.ticks,
+           summary.p50, summary.p95, summary.p99, summary.max);
+    Append(json,
+           "\"syscalls\":%.1f,\"bytes_read\":%.0f,\"allocations\":%.1f}",
+           summary.syscalls, summary.bytes_read, summary.allocations);
+  }
+  json += "]}\n";
+
+  auto responses = std::make_shared<Responses>();
+  responses->metrics =
+      Http("200 OK", "text/plain; version=0.0.4; charset=utf-8", metrics);
+  responses->json = Http("200 OK", "application/x-ndjson", json);
+  std::lock_guard<std::mutex> lock(mutex_);
+  responses_ = std::move(responses);
+}
+
+// single threaded poll loop, a request is answered with a buffer of the
+// responses published last
+void Exporter::Serve() {
+  static const string not_found =
+      Http("404 Not Found", "text/plain", "try /metrics or /json\n");
+  static const string not_ready =
+      Http("503 Service Unavailable", "text/plain", "no sample yet\n");
+  static const string bad_request =
+      Http("400 Bad Request", "text/plain", "bad request\n");
+
+  using std::chrono::steady_clock;
+  vector<Client> clients;
+  vector<pollfd> polled;
+  while (true) {
+    // the poll wakes up for the earliest deadline of a client
+    int timeout = -1;
+    if (!clients.empty()) {
+      steady_clock::time_point deadline = clients[0].Deadline();
+      for (const Client& client : clients) {
+        deadline = std::min(deadline, client.Deadline());
+      }
+      auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - steady_clock::now());
+      timeout = std::max(0L, static_cast<long>(wait.count()) + 1);
+    }
+    polled.clear();
+    polled.push_back(pollfd{wake_, POLLIN, 0});
+    short accepting = clients.size() < kMaxClients ? POLLIN : 0;
+    polled.push_back(pollfd{listener_, accepting, 0});
+    for (const Client& client : clients) {
+      short events = client.response == nullptr ? POLLIN : POLLOUT;
+      polled.push_back(pollfd{client.fd, events, 0});
+    }
+    if (poll(polled.data(), polled.size(), timeout) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (polled[0].revents != 0) {
+      break;
+    }
+
+    steady_clock::time_point now = steady_clock::now();
+    for (size_t i = 0; i < clients.size(); ++i) {
+      Client& client = clients[i];
+      short revents = polled[i + 2].revents;
+      bool done = (revents & (POLLERR | POLLNVAL)) != 0;
+      if (!done && client.response == nullptr && (revents & POLLIN) != 0) {
+        char buffer[1024];
+        ssize_t length = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+          done = true;
+        } else {
+          client.request.append(buffer, length);
+          bool complete = client.request.find("\r\n\r\n") != string::npos ||
+                          client.request.find("\n\n") != string::npos;
+          if (client.request.size() > kMaxRequest) {
+            client.response = &bad_request;
+          } else if (complete) {
+            std::shared_ptr<const Responses> responses = Latest();
+            bool metrics = client.request.compare(0, 13, "GET /metrics ") == 0;
+            bool json = client.request.compare(0, 10, "GET /json ") == 0;
+            if (!metrics && !json) {
+              client.response = &not_found;
+            } else if (responses == nullptr) {
+              client.response = &not_ready;
+            } else {
+              client.response =
+                  metrics ? &responses->metrics : &responses->json;
+              client.keep = responses;
+            }
+          }
+          // the response gets its own deadline
+          client.active = now;
+        }
+      } else if (!done && client.response != nullptr &&
+                 (revents & POLLOUT) != 0) {
+        const string& response = *client.response;
+        ssize_t length =
+            send(client.fd, response.data() + client.written,
+                 response.size() - client.written, MSG_NOSIGNAL);
+        if (length < 0 && errno != EAGAIN && errno != EINTR) {
+          done = true;
+        } else if (length > 0) {
+          client.active = now;
+          client.written += length;
+          done = client.written == response.size();
+        }
+      } else if ((revents & POLLHUP) != 0) {
+        done = true;
+      }
+      if (!done && now >= client.Deadline()) {
+        done = true;
+      }
+      if (done) {
+        close(client.fd);
+        client.fd = -1;
+      }
+    }
+    clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                 [](const Client& client) {
+                                   return client.fd < 0;
+                                 }),
+                  clients.end());
+
+    if ((polled[1].revents & POLLIN) != 0) {
+      while (clients.size() < kMaxClients) {
+        int fd = accept4(listener_, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+          break;
+        }
+        steady_clock::time_point now = steady_clock::now();
+        clients.push_back(Client{fd, now, now, string(), nullptr, nullptr, 0});
+      }
+    }
+  }
+  for (const Client& client : clients) {
+    close(client.fd);
+  }
+}
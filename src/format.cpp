@@ -1,3 +1,5 @@
+#include <cstdio>
+#include <ctime>
 #include <string>
 #include <sstream>
 #include <iomanip>
@@ -21,3 +23,20 @@ string Format::ElapsedTime(long seconds) {
   stream << to_string(seconds % 60);  // seconds
   return stream.str();
 }
+
+char* Format::ElapsedTime(long seconds, char* buffer, std::size_t size) {
+  std::snprintf(buffer, size, "%02ld:%02ld:%02ld", seconds / 3600,
+                seconds % 3600 / 60, seconds % 60);
+  return buffer;
+}
+
+string Format::DateTime(long seconds) {
+  std::time_t time = seconds;
+  std::tm local;
+  char buffer[32];
+  if (localtime_r(&time, &local) == nullptr ||
+      std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local) == 0) {
+    return string();
+  }
+  return buffer;
+}
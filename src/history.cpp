@@ -0,0 +1,153 @@
+#include <algorithm>
+
+#include "history.h"
+
+using std::size_t;
+using std::vector;
+
+namespace {
+const long kFineWidth{1};
+const size_t kFinePoints{600};  // 10 minutes
+const long kCoarseWidth{10};
+const size_t kCoarsePoints{2160};  // 6 hours
+// processes out of the top rows for longer are forgotten
+const long kProcessRetention{60};
+const size_t kMaxProcesses{64};
+// only the first rows of the top get a history
+const size_t kTrackedRows{32};
+}  // namespace
+
+Series::Level::Level(long width, size_t capacity)
+    : points(capacity), width(width) {}
+
+// a point is the average of the samples which fall in its bucket
+void Series::Level::Add(long second, float value) {
+  long current = second / width;
+  if (current != bucket && count > 0) {
+    points.Push(Point{bucket, static_cast<float>(sum / count)});
+    sum = 0;
+    count = 0;
+  }
+  bucket = current;
+  sum += value;
+  ++count;
+}
+
+// the points are in bucket order, the search starts from the newest
+size_t Series::Level::Since(long second, long seconds) const {
+  long first = (second - seconds) / width + 1;
+  size_t i = points.Size();
+  while (i > 0 && points[i - 1].bucket >= first) {
+    --i;
+  }
+  return i;
+}
+
+Series::Series()
+    : fine_(kFineWidth, kFinePoints), coarse_(kCoarseWidth, kCoarsePoints) {}
+
+void Series::Add(long second, float value) {
+  fine_.Add(second, value);
+  coarse_.Add(second, value);
+  second_ = second;
+}
+
+SeriesStats Series::Query(long seconds) const {
+  const Level& level =
+      seconds <= long(kFinePoints) * kFineWidth ? fine_ : coarse_;
+  size_t first = level.Since(second_, std::max(seconds, level.width));
+  size_t count = level.points.Size() - first;
+  SeriesStats stats;
+  if (count == 0) {
+    return stats;
+  }
+  vector<float> values(count);
+  double sum = 0;
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = level.points[first + i].value;
+    sum += values[i];
+  }
+  auto minmax = std::minmax_element(values.begin(), values.end());
+  stats.min = *minmax.first;
+  stats.max = *minmax.second;
+  stats.avg = sum / count;
+  auto p95 = values.begin() + (count - 1) * 95 / 100;
+  std::nth_element(values.begin(), p95, values.end());
+  stats.p95 = *p95;
+  stats.points = count;
+  return stats;
+}
+
+void Series::Latest(size_t count, vector<float>& points) const {
+  size_t first = fine_.Since(second_, count * kFineWidth);
+  points.resize(fine_.points.Size() - first);
+  for (size_t i = 0; i < points.size(); ++i) {
+    points[i] = fine_.points[first + i].value;
+  }
+}
+
+void History::Add(long second, const Processor& cpu,
+                  const SystemSnapshot& snapshot, vector<Process>& top) {
+  cpu_.Add(second, cpu.Share().utilization);
+  memory_.Add(second, snapshot.memory_utilization);
+  if (cores_.size() != size_t(cpu.Cores())) {
+    cores_.resize(cpu.Cores());
+  }
+  for (size_t core = 0; core < cores_.size(); ++core) {
+    cores_[core].Add(second, cpu.Share(core).utilization);
+  }
+
+  for (size_t i = 0; i < std::min(top.size(), kTrackedRows); ++i) {
+    Process& process = top[i];
+    ProcessSeries& series = processes_[process.Pid()];
+    // a reused PID starts a new history
+    if (series.start_time != process.StartTime()) {
+      series = ProcessSeries{};
+      series.start_time = process.StartTime();
+    }
+    series.last_seen = second;
+    series.cpu.Add(second, process.CpuUtilization());
+    series.rss.Add(second, process.RssKb());
+  }
+  Evict(second);
+}
+
+// keep the processes seen lately, at most kMaxProcesses of them
+void History::Evict(long second) {
+  for (auto it = processes_.begin(); it != processes_.end();) {
+    if (second - it->second.last_seen > kProcessRetention) {
+      it = processes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  while (processes_.size() > kMaxProcesses) {
+    auto oldest = std::min_element(
+        processes_.begin(), processes_.end(), [](const auto& a, const auto& b) {
+          return a.second.last_seen < b.second.last_seen;
+        });
+    processes_.erase(oldest);
+  }
+}
+
+const Series& History::Cpu() const {
+  return cpu_;
+}
+
+const Series& History::Core(int core) const {
+  return cores_[core];
+}
+
+const Series& History::Memory() const {
+  return memory_;
+}
+
+const Series* History::ProcessCpu(int pid) const {
+  auto found = processes_.find(pid);
+  return found == processes_.end() ? nullptr : &found->second.cpu;
+}
+
+const Series* History::ProcessRss(int pid) const {
+  auto found = processes_.find(pid);
+  return found == processes_.end() ? nullptr : &found->second.rss;
+}
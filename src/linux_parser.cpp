@@ -1,106 +1,265 @@
+#include <fnmatch.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
 #include <string>
 #include <vector>
 #include <numeric>
-#include <experimental/filesystem>
 
 #include "linux_parser.h"
+#include "passwd_cache.h"
+#include "proc_reader.h"
 
 using std::stof;
 using std::string;
+using std::string_view;
 using std::to_string;
 using std::vector;
-namespace filesystem = std::experimental::filesystem;
+
+namespace {
+// the filename constants start with '/', reads relative to the proc root don't
+const char* Relative(const string& filename) {
+  return filename.c_str() + 1;
+}
+
+string proc_directory{LinuxParser::kProcDirectory};
+vector<string> interface_globs;
+
+bool Matches(const vector<string>& globs, const char* name) {
+  if (globs.empty()) {
+    return true;
+  }
+  for (const string& glob : globs) {
+    if (fnmatch(glob.c_str(), name, 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// "name:" then 8 receive and 8 transmit counters, the name may touch
+// the first counter. The counters are only scanned when scan is set and
+// the name matches the globs
+bool ParseInterface(string_view line, const vector<string>& globs,
+                    LinuxParser::InterfaceCounters& counters, bool scan) {
+  size_t colon = line.find(':');
+  if (colon == string_view::npos) {
+    return false;
+  }
+  size_t start = std::min(line.find_first_not_of(' '), colon);
+  string_view name = line.substr(start, colon - start);
+  if (name.empty() || name.size() >= counters.name.size()) {
+    return false;
+  }
+  std::copy(name.begin(), name.end(), counters.name.begin());
+  counters.name[name.size()] = '\0';
+  if (!Matches(globs, counters.name.data())) {
+    return false;
+  }
+  if (!scan) {
+    return true;
+  }
+  string_view cursor = line.substr(colon + 1);
+  long fields[16];
+  for (long& field : fields) {
+    if (!ProcReader::ScanLong(cursor, field)) {
+      return false;
+    }
+  }
+  counters.rx_bytes = fields[0];
+  counters.rx_packets = fields[1];
+  counters.rx_errors = fields[2];
+  counters.rx_drops = fields[3];
+  counters.tx_bytes = fields[8];
+  counters.tx_packets = fields[9];
+  counters.tx_errors = fields[10];
+  counters.tx_drops = fields[11];
+  return true;
+}
+}  // namespace
+
+bool LinuxParser::ProcDirectory(const string& directory) {
+  proc_directory = directory;
+  if (proc_directory.empty() || proc_directory.back() != '/') {
+    proc_directory += '/';
+  }
+  return ProcReader::Root(proc_directory.c_str());
+}
+
+const string& LinuxParser::ProcDirectory() {
+  return proc_directory;
+}
+
+void LinuxParser::Interfaces(const string& globs) {
+  interface_globs.clear();
+  size_t start = 0;
+  while (start <= globs.size()) {
+    size_t end = std::min(globs.find(',', start), globs.size());
+    if (end > start) {
+      interface_globs.push_back(globs.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+}
 
 // DONE: An example of how to read data from the filesystem
 string LinuxParser::OperatingSystem() {
-  string line;
-  string key;
-  string value;
-  std::ifstream file_stream(kOSPath);
-  if (file_stream.is_open()) {
-    while (std::getline(file_stream, line)) {
-      std::replace(line.begin(), line.end(), ' ', '_');
-      std::replace(line.begin(), line.end(), '=', ' ');
-      std::replace(line.begin(), line.end(), '"', ' ');
-      std::istringstream line_stream(line);
-      while (line_stream >> key >> value) {
-        if (key == "PRETTY_NAME") {
-          std::replace(value.begin(), value.end(), '_', ' ');
-          return value;
-        }
-      }
-    }
+  string_view text = ProcReader::ReadPath(kOSPath.c_str());
+  string_view value = ProcReader::FindKey(text, "PRETTY_NAME=");
+  if (!value.empty() && value.front() == '"') {
+    value.remove_prefix(1);
+    value = value.substr(0, value.find('"'));
   }
-  return value;
+  return string(value);
 }
 
 // DONE: An example of how to read data from the filesystem
 string LinuxParser::Kernel() {
-  string os, kernel, version;
-  string line;
-  std::ifstream stream(kProcDirectory + kVersionFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream line_stream(line);
-    line_stream >> os >> version >> kernel;
-  }
-  return kernel;
+  // "Linux version <kernel> ..."
+  string_view cursor = ProcReader::Read(Relative(kVersionFilename));
+  ProcReader::NextToken(cursor);
+  ProcReader::NextToken(cursor);
+  return string(ProcReader::NextToken(cursor));
 }
 
 // BONUS: Update this to use std::filesystem
-// DONE: By using std::filesystem
+// DONE: By using getdents64, see ProcReader::Pids()
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  for (const auto &entry: filesystem::directory_iterator(kProcDirectory)) {
-    // Is this a directory?
-    if (filesystem::is_directory(entry.path())) {
-      // Is every character of the name a digit?
-      string filename{filesystem::path(entry.path()).filename()};
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
-      }
+  ProcReader::Pids(pids);
+  return pids;
+}
+
+// lines are found by key, their order differs between kernels
+LinuxParser::Memory LinuxParser::MemoryInfo() {
+  string_view text = ProcReader::Read(Relative(kMeminfoFilename));
+  Memory memory;
+  memory.total_kb = ProcReader::ValueByKey(text, "MemTotal:");
+  memory.free_kb = ProcReader::ValueByKey(text, "MemFree:");
+  memory.buffers_kb = ProcReader::ValueByKey(text, "Buffers:");
+  memory.cached_kb = ProcReader::ValueByKey(text, "Cached:");
+  // kernels before 3.14 have no MemAvailable, the cache is free there
+  memory.available_kb = ProcReader::ValueByKey(
+      text, "MemAvailable:",
+      memory.free_kb + memory.buffers_kb + memory.cached_kb);
+  memory.swap_total_kb = ProcReader::ValueByKey(text, "SwapTotal:");
+  memory.swap_free_kb = ProcReader::ValueByKey(text, "SwapFree:");
+  return memory;
+}
+
+// major minor name, then the numbered fields of
+// Documentation/admin-guide/iostats.rst
+void LinuxParser::DiskStats(vector<Disk>& disks) {
+  string_view text = ProcReader::Read(Relative(kDiskstatsFilename));
+  size_t count = 0;
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    string_view cursor = text.substr(0, end);
+    text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+    ProcReader::NextToken(cursor);
+    ProcReader::NextToken(cursor);
+    string_view name = ProcReader::NextToken(cursor);
+    long fields[10];
+    bool complete = !name.empty();
+    for (int i = 0; complete && i < 10; ++i) {
+      complete = ProcReader::ScanLong(cursor, fields[i]);
+    }
+    if (!complete || (fields[0] == 0 && fields[4] == 0)) {
+      continue;
+    }
+    if (count == disks.size()) {
+      disks.emplace_back();
+    }
+    Disk& disk = disks[count++];
+    disk.name.assign(name.data(), name.size());
+    disk.reads = fields[0];
+    disk.read_sectors = fields[2];
+    disk.writes = fields[4];
+    disk.write_sectors = fields[6];
+    disk.io_ms = fields[9];
+  }
+  disks.resize(count);
+}
+
+// one read of each file, lines of interfaces which don't match the
+// globs are skipped before their counters are scanned. Matching lines
+// past the first kInterfaces are only counted
+void LinuxParser::NetworkStats(NetworkCounters& network) {
+  string_view text = ProcReader::Read(Relative(kNetDevFilename));
+  network.count = 0;
+  network.hidden = 0;
+  // two header lines
+  for (int line = 0; line < 2 && !text.empty(); ++line) {
+    size_t end = text.find('\n');
+    text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+  }
+  InterfaceCounters hidden;
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    string_view line = text.substr(0, end);
+    text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+    if (network.count == kInterfaces) {
+      network.hidden += ParseInterface(line, interface_globs, hidden, false);
+    } else if (ParseInterface(line, interface_globs,
+                              network.interfaces[network.count], true)) {
+      ++network.count;
+    }
+  }
+
+  // a line of names followed by a line of values
+  text = ProcReader::Read(Relative(kNetSnmpFilename));
+  string_view names = ProcReader::FindKey(text, "Tcp:");
+  string_view values;
+  if (!names.empty()) {
+    size_t names_end = text.find('\n', names.data() - text.data());
+    if (names_end != string_view::npos) {
+      values = ProcReader::FindKey(text.substr(names_end + 1), "Tcp:");
+    }
+  }
+  network.tcp_in_segments = 0;
+  network.tcp_out_segments = 0;
+  network.tcp_retransmits = 0;
+  while (!names.empty()) {
+    string_view name = ProcReader::NextToken(names);
+    long value;
+    if (name.empty() || !ProcReader::ScanLong(values, value)) {
+      break;
+    }
+    if (name == "InSegs") {
+      network.tcp_in_segments = value;
+    } else if (name == "OutSegs") {
+      network.tcp_out_segments = value;
+    } else if (name == "RetransSegs") {
+      network.tcp_retransmits = value;
     }
   }
-  return pids;
 }
 
 // DONE: Read and return the system memory utilization
 float LinuxParser::MemoryUtilization() {
-  float memory_utilized = 0.0;
-  std::ifstream stream(kProcDirectory + kMeminfoFilename);
-  if (stream.is_open()) {
-    string line, temp;
-    std::getline(stream, line);
-    std::istringstream total_mem_line_stream(line);
-    float total_memory, free_memory;
-    total_mem_line_stream >> temp >> total_memory;
-    std::getline(stream, line);
-    std::istringstream free_mem_line_stream(line);
-    free_mem_line_stream >> temp >> free_memory;
-    memory_utilized = (total_memory - free_memory) / total_memory;
+  return MemoryUtilization(MemoryInfo());
+}
+
+float LinuxParser::MemoryUtilization(const Memory& memory) {
+  if (memory.total_kb <= 0) {
+    return 0.0;
   }
-  return memory_utilized;
+  return float(memory.total_kb - memory.available_kb) / memory.total_kb;
 }
 
 // DONE: Read and return the system uptime
 long LinuxParser::UpTime() {
   long uptime = 0;
-  std::ifstream stream(kProcDirectory + kUptimeFilename);
-  if (stream.is_open()) {
-    string line;
-    std::getline(stream, line);
-    std::istringstream line_stream(line);
-    line_stream >> uptime;
-  }
+  string_view cursor = ProcReader::Read(Relative(kUptimeFilename));
+  ProcReader::ScanLong(cursor, uptime);
   return uptime;
 }
 
 // DONE: Read and return the number of jiffies for the system
 long LinuxParser::Jiffies() {
 //  return sysconf(_SC_CLK_TCK) * UpTime();
-  return ActiveJiffies() + IdleJiffies();
+  return Jiffies(CpuJiffies().data());
 }
 
 // DONE: Read and return the number of active jiffies for a PID
@@ -111,201 +270,230 @@ long LinuxParser::Jiffies() {
  * utime, stime, cutime, cstime
  */
 long LinuxParser::ActiveJiffies(int pid) {
-  long active_jiffies = 0;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    string line;
-    std::getline(stream, line);
-    /**
-     * Active Jiffies of any process is the sum of
-     * 14th to 17th attributes in /proc/[pid]/stat file
-     */
-     std::istringstream line_stream(line);
-     // ignoring first 13 values
-     for(int i=0; i<13; ++i) {
-       line_stream.ignore(256, ' ');
-     }
-     long utime, stime, cutime, cstime;
-     line_stream >> utime >> stime >> cutime >> cstime;
-     active_jiffies = utime + stime + cutime + cstime;
+  ProcReader::PidStat stat;
+  if (!ProcessStat(pid, stat)) {
+    return 0;
   }
-  return active_jiffies;
+  return stat.utime + stat.stime + stat.cutime + stat.cstime;
 }
 
 // DONE: Read and return the number of active jiffies for the system
 long LinuxParser::ActiveJiffies() {
-  auto cpu_data = CpuUtilization();
-  return std::accumulate(cpu_data.begin(), cpu_data.end(), 0,
-                         [](const long previous, const string& p){
-                           return previous + std::stol(p);
-                         });
+  return ActiveJiffies(CpuJiffies().data());
 }
 
 // DONE: Read and return the number of idle jiffies for the system
 long LinuxParser::IdleJiffies() {
-  auto cpu_data = CpuUtilization();
-  return std::stol(cpu_data[CPUStates::kIdle_]) + std::stol(cpu_data[CPUStates::kIOwait_]);
+  return IdleJiffies(CpuJiffies().data());
+}
+
+/**
+ * Total jiffies are the sum of user to steal time, guest and
+ * guest_nice are already accounted in user and nice by the kernel
+ */
+long LinuxParser::Jiffies(const uint64_t* cpu_jiffies) {
+  return std::accumulate(cpu_jiffies, cpu_jiffies + CPUStates::kGuest_, 0UL);
+}
+
+long LinuxParser::ActiveJiffies(const uint64_t* cpu_jiffies) {
+  return Jiffies(cpu_jiffies) - IdleJiffies(cpu_jiffies);
+}
+
+long LinuxParser::IdleJiffies(const uint64_t* cpu_jiffies) {
+  return cpu_jiffies[CPUStates::kIdle_] + cpu_jiffies[CPUStates::kIOwait_];
+}
+
+// Read the aggregate cpu line once and return it as numbers
+vector<uint64_t> LinuxParser::CpuJiffies() {
+  vector<uint64_t> cpu_jiffies;
+  CpuJiffies(cpu_jiffies);
+  cpu_jiffies.resize(kCpuStates);
+  return cpu_jiffies;
+}
+
+/**
+ * Parse every cpu line of /proc/stat into rows of kCpuStates counters,
+ * row 0 is the aggregate "cpu" line and row n + 1 is "cpun". Offline
+ * cpus have no line and keep a row of zeros. The process counters
+ * follow the cpu lines and are parsed from the same read
+ */
+void LinuxParser::CpuJiffies(vector<uint64_t>& jiffies,
+                             ProcessCounts& processes) {
+  jiffies.assign(kCpuStates, 0);
+  string_view text = ProcReader::Read(Relative(kStatFilename));
+  // the cpu lines come first
+  while (text.size() > 3 && text.compare(0, 3, "cpu") == 0) {
+    size_t end = text.find('\n');
+    string_view cursor = text.substr(0, end);
+    cursor.remove_prefix(3);
+    size_t row = 0;
+    long cpu;
+    if (std::isdigit(cursor.front()) && ProcReader::ScanLong(cursor, cpu)) {
+      row = cpu + 1;
+    }
+    if (jiffies.size() < (row + 1) * kCpuStates) {
+      jiffies.resize((row + 1) * kCpuStates, 0);
+    }
+    for (int state = 0; state < kCpuStates; ++state) {
+      if (!ProcReader::ScanUnsigned(cursor,
+                                    jiffies[row * kCpuStates + state])) {
+        break;
+      }
+    }
+    if (end == string_view::npos) {
+      break;
+    }
+    text.remove_prefix(end + 1);
+  }
+  processes.total = ProcReader::ValueByKey(text, "processes");
+  processes.running = ProcReader::ValueByKey(text, "procs_running");
+}
+
+void LinuxParser::CpuJiffies(vector<uint64_t>& jiffies) {
+  ProcessCounts processes;
+  CpuJiffies(jiffies, processes);
 }
 
 // DONE: Read and return CPU utilization
 vector<string> LinuxParser::CpuUtilization() {
-  vector<string> cpu_utilization(10);
-  std::ifstream stream(kProcDirectory + kStatFilename);
-  if (stream.is_open()) {
-    string line, temp;
-    string c_user, c_nice, c_system, c_idle, c_iowait;
-    string c_irq, c_softirq, c_steal, c_guest, c_guestnice;
-
-    std::getline(stream, line);
-    std::istringstream line_stream(line);
-    line_stream >> temp >> c_user >> c_nice >> c_system >> c_idle >> c_iowait;
-    line_stream >> c_irq >> c_softirq >> c_steal >> c_guest >> c_guestnice;
-
-    cpu_utilization[LinuxParser::CPUStates::kUser_] = c_user;
-    cpu_utilization[LinuxParser::CPUStates::kNice_] = c_nice;
-    cpu_utilization[LinuxParser::CPUStates::kSystem_] = c_system;
-    cpu_utilization[LinuxParser::CPUStates::kIdle_] = c_idle;
-    cpu_utilization[LinuxParser::CPUStates::kIOwait_] = c_iowait;
-    cpu_utilization[LinuxParser::CPUStates::kIRQ_] = c_irq;
-    cpu_utilization[LinuxParser::CPUStates::kSoftIRQ_] = c_softirq;
-    cpu_utilization[LinuxParser::CPUStates::kSteal_] = c_steal;
-    cpu_utilization[LinuxParser::CPUStates::kGuest_] = c_guest;
-    cpu_utilization[LinuxParser::CPUStates::kGuestNice_] = c_guestnice;
+  vector<string> cpu_utilization;
+  for (uint64_t jiffies: CpuJiffies()) {
+    cpu_utilization.push_back(to_string(jiffies));
   }
   return cpu_utilization;
 }
 
 // DONE: Read and return the total number of processes
 int LinuxParser::TotalProcesses() {
-  std::string proc_stat_filepath{kProcDirectory + kStatFilename};
-  return std::stoi(GetFileLineDataByKey(proc_stat_filepath, "processes"));
+  return ProcReader::ValueByKey(ProcReader::Read(Relative(kStatFilename)),
+                                "processes");
 }
 
 // DONE: Read and return the number of running processes
 int LinuxParser::RunningProcesses() {
-  std::string proc_stat_filepath{kProcDirectory + kStatFilename};
-  return std::stoi(GetFileLineDataByKey(proc_stat_filepath, "procs_running"));
+  return ProcReader::ValueByKey(ProcReader::Read(Relative(kStatFilename)),
+                                "procs_running");
+}
+
+// Read and parse /proc/[pid]/stat, stat.comm is only valid
+// until the next read made by the calling thread
+bool LinuxParser::ProcessStat(int pid, ProcReader::PidStat& stat) {
+  return ProcReader::ParsePidStat(
+      ProcReader::ReadPid(pid, Relative(kStatFilename)), stat);
 }
 
 // DONE: Read and return the command associated with a process
 string LinuxParser::Command(int pid) {
-  string command_filename = kProcDirectory + to_string(pid) + kCmdlineFilename;
-  std::istringstream line_stream(GetFileLineData(command_filename, 0));
-  std::string command;
-  line_stream >> command;
+  // arguments are separated by '\0', show them separated by blanks
+  string command(ProcReader::ReadPid(pid, Relative(kCmdlineFilename)));
+  while (!command.empty() && command.back() == '\0') {
+    command.pop_back();
+  }
+  std::replace(command.begin(), command.end(), '\0', ' ');
   return command;
 }
 
 // DONE: Read and return the memory used by a process
 unsigned int LinuxParser::Ram(int pid) {
-  unsigned int ram;
-  string line_data, temp;
-  string command_filename = kProcDirectory + to_string(pid) + kStatusFilename;
-  //memory utilisation information is at line# 17 starting from 0
-  line_data = GetFileLineData(command_filename, 17);
-  std::istringstream line_stream(line_data);
-  line_stream >> temp >> ram;
+  long ram = 0;
+  // by key, the line number of VmRSS differs between kernels
+  string_view cursor = ProcReader::FindKey(ProcReader::ReadPid(pid, Relative(kStatusFilename)), "VmRSS:");
+  ProcReader::ScanLong(cursor, ram);
   return ram;
 }
 
+bool LinuxParser::ProcessIo(int pid, Io& io) {
+  string_view text = ProcReader::ReadPid(pid, Relative(kIoFilename));
+  if (text.empty()) {
+    return false;
+  }
+  io.read_bytes = ProcReader::ValueByKey(text, "read_bytes:");
+  io.write_bytes = ProcReader::ValueByKey(text, "write_bytes:");
+  return true;
+}
+
+// a single summary of all mappings, uss is the private part of rss
+bool LinuxParser::SmapsRollup(int pid, Smaps& smaps) {
+  string_view text = ProcReader::ReadPid(pid, Relative(kSmapsRollupFilename));
+  if (text.empty()) {
+    return false;
+  }
+  smaps.rss_kb = ProcReader::ValueByKey(text, "Rss:");
+  smaps.pss_kb = ProcReader::ValueByKey(text, "Pss:");
+  smaps.uss_kb = ProcReader::ValueByKey(text, "Private_Clean:") +
+                 ProcReader::ValueByKey(text, "Private_Dirty:");
+  return true;
+}
+
+// the v2 line is "0::path", v1 hierarchies have their own lines. Empty
+// when the file can't be read or has no v2 line
+string LinuxParser::Cgroup(int pid) {
+  string_view path = ProcReader::FindKey(
+      ProcReader::ReadPid(pid, Relative(kCgroupFilename)), "0::");
+  return string(path);
+}
+
 // DONE: Read and return the user ID associated with a process
 string LinuxParser::Uid(int pid) {
-  string uid;
-  string line_data, temp;
-  string command_filename = kProcDirectory + to_string(pid) + kStatusFilename;
-  //process uid information is at line# 8 starting from 0
-  line_data = GetFileLineData(command_filename, 8);
-  std::istringstream line_stream(line_data);
-  line_stream >> temp >> uid;
-  return uid;
+  string_view cursor = ProcReader::FindKey(ProcReader::ReadPid(pid, Relative(kStatusFilename)), "Uid:");
+  return string(ProcReader::NextToken(cursor));
 }
 
 // DONE: Read and return the user associated with a process
 string LinuxParser::User(int pid) {
-  string username;
-  string user_data = GetPasswdUserData(std::stoi(Uid(pid)));
-  if (user_data.empty()) {
-    return username;
-  }
-  std::istringstream line_stream(user_data);
-  std::getline(line_stream, username, ':');
-  return username;
+  return UserName(Owner(pid));
+}
+
+// the owner of the PID directory, as top and htop show, which costs a
+// stat instead of reading the status file
+long LinuxParser::Owner(int pid) {
+  unsigned int uid;
+  return ProcReader::Owner(pid, uid) ? static_cast<long>(uid) : -1;
+}
+
+string LinuxParser::UserName(long uid) {
+  // uid to name lookups go through an index of the passwd file
+  static PasswdCache passwd_cache(kPasswordPath);
+  return uid < 0 ? string() : passwd_cache.Name(uid);
 }
 
 // DONE: Read and return the uptime of a process
 long LinuxParser::UpTime(int pid) {
-  long uptime = 0;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    string line;
-    std::getline(stream, line);
-    /**
-     * Up time is the 21st attribute in /proc/[pid]/stat file, starting from 0
-     */
-    std::istringstream line_stream(line);
-    // ignoring first 21 values
-    for(int i=0; i<21; ++i) {
-      line_stream.ignore(256, ' ');
-    }
-    long start_time;
-    line_stream >> start_time;
-    // converting clock ticks to seconds
-    start_time /= sysconf(_SC_CLK_TCK);
-    uptime = UpTime() - start_time;
+  ProcReader::PidStat stat;
+  if (!ProcessStat(pid, stat)) {
+    return 0;
   }
-  return uptime;
+  /**
+   * Up time is the 22nd field of /proc/[pid]/stat,
+   * converting clock ticks to seconds
+   */
+  long start_time = stat.starttime / sysconf(_SC_CLK_TCK);
+  return UpTime() - start_time;
 }
 
 // helper functions
 std::string LinuxParser::GetFileLineDataByKey(const string& filename, const std::string& key) {
-  string line_data;
-  std::ifstream stream(filename);
-  if (stream.is_open()) {
-    string line, line_key;
-    while(getline(stream, line)) {
-      std::istringstream line_stream(line);
-      line_stream >> line_key;
-      if (line_key == key) {
-        line_stream >> line_data;
-        break;
-      }
-    }
-  }
-  return line_data;
+  string_view cursor = ProcReader::FindKey(ProcReader::ReadPath(filename.c_str()), key);
+  return string(ProcReader::NextToken(cursor));
 }
 
 std::string LinuxParser::GetFileLineData(const std::string &filename, unsigned int line_no) {
   // line index start from 0
-  string line_data;
-  std::ifstream stream(filename);
-  if (stream.is_open()) {
-    unsigned int i = 0;
-    while(getline(stream, line_data) && i < line_no) {
-      ++i;
-    }
-    if (i != line_no) {
-      line_data = "";
-    }
-  }
-  return line_data;
+  return string(ProcReader::NthLine(ProcReader::ReadPath(filename.c_str()), line_no));
 }
 
-std::string LinuxParser::GetPasswdUserData(unsigned int uid) {
-  // line index start from 0
-  string user_data, user_id_str, _;
-  std::ifstream stream(kPasswordPath);
-  if (stream.is_open()) {
-    unsigned int user_id = -999;
-    while(user_id != uid && getline(stream, user_data)) {
-      std::istringstream line_stream(user_data);
-      std::getline(line_stream, _, ':');
-      std::getline(line_stream, _, ':');
-      std::getline(line_stream, user_id_str, ':');
-      user_id = std::stoi(user_id_str);
-    }
-    if (user_id != uid) {
-      user_data = "";
-    }
-  }
-  return user_data;
-}
\ No newline at end of file
+// tasks of a process are listed like the PIDs of the proc root
+void LinuxParser::Tids(int pid, vector<int>& tids) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "%d%s", pid, kTaskDirectory.c_str());
+  ProcReader::Pids(path, tids);
+}
+
+// /proc/[pid]/task/[tid]/stat, its comm is the name of the thread
+bool LinuxParser::ThreadStat(int pid, int tid, ProcReader::PidStat& stat) {
+  char name[64];
+  // relative to the directory of pid, without the leading '/'
+  std::snprintf(name, sizeof(name), "%s/%d%s", kTaskDirectory.c_str() + 1, tid,
+                kStatFilename.c_str());
+  return ProcReader::ParsePidStat(ProcReader::ReadPid(pid, name), stat);
+}
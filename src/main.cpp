@@ -1,7 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alerts.h"
+#include "exporter.h"
+#include "linux_parser.h"
 #include "ncurses_display.h"
+#include "options.h"
+#include "process_filter.h"
+#include "recording.h"
+#include "sampler.h"
 #include "system.h"
 
-int main() {
+namespace {
+volatile std::sig_atomic_t stopped = 0;
+
+void Stop(int) {
+  stopped = 1;
+}
+
+// samples at the fixed rate of the interval without a display, until
+// SIGINT or SIGTERM or until tick fails. The alert events of every tick
+// are written out
+bool Headless(System& system, const Options& options,
+              const std::function<bool(std::vector<Process>&)>& tick) {
+  std::signal(SIGINT, Stop);
+  std::signal(SIGTERM, Stop);
+  AlertOutput alerts;
+  if (!options.alerts.empty()) {
+    if (!alerts.Open(options.alert_log)) {
+      std::perror(options.alert_log.c_str());
+      return false;
+    }
+    alerts.Hook(options.alert_hook);
+  }
+  auto interval = std::max(std::chrono::milliseconds(options.interval_ms),
+                           Sampler::kMinInterval);
+  auto deadline = std::chrono::steady_clock::now();
+  while (!stopped) {
+    if (!tick(system.Processes())) {
+      return false;
+    }
+    alerts.Write(system.AlertEvents());
+    auto now = std::chrono::steady_clock::now();
+    while (deadline <= now) {
+      deadline += interval;
+    }
+    std::this_thread::sleep_until(deadline);
+  }
+  return true;
+}
+
+// every process of every tick goes into the recording
+int Record(System& system, const Options& options) {
+  Recorder recorder;
+  if (!recorder.Open(options.record, system.OperatingSystem(),
+                     system.Kernel())) {
+    std::perror(options.record.c_str());
+    return 1;
+  }
+  system.TopCount(0);
+  TickRecord tick;
+  bool recorded = Headless(system, options, [&](std::vector<Process>&) {
+    system.Record(tick);
+    if (!recorder.Write(tick)) {
+      std::perror(options.record.c_str());
+      return false;
+    }
+    return true;
+  });
+  return recorded ? 0 : 1;
+}
+
+int Export(System& system, const Options& options) {
+  // SIGPIPE of a scraper hanging up is handled per write
+  std::signal(SIGPIPE, SIG_IGN);
+  Exporter exporter;
+  if (!exporter.Listen(options.address)) {
+    std::perror(options.address.c_str());
+    return 1;
+  }
+  system.TopCount(Exporter::kProcesses);
+  system.GroupByCgroup(true);
+  bool exported =
+      Headless(system, options, [&](std::vector<Process>& processes) {
+        exporter.Publish(system, processes);
+        return true;
+      });
+  return exported ? 0 : 1;
+}
+
+// the rules read every process, no rows get ordered
+int Watch(System& system, const Options& options) {
+  system.TopCount(0);
+  bool watched = Headless(system, options,
+                          [](std::vector<Process>&) { return true; });
+  return watched ? 0 : 1;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!Options::Parse(argc, argv, options)) {
+    Options::PrintUsage(argv[0]);
+    return 1;
+  }
+  if (!options.proc_root.empty() &&
+      !LinuxParser::ProcDirectory(options.proc_root)) {
+    std::perror(options.proc_root.c_str());
+    return 1;
+  }
+  LinuxParser::Interfaces(options.interfaces);
+  const int rows{10};
   System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+  ProcessFilter filter;
+  std::string error;
+  if (!ProcessFilter::Compile(options.filter, filter, error)) {
+    std::fprintf(stderr, "--filter: %s\n", error.c_str());
+    return 1;
+  }
+  system.FilterBy(filter);
+  for (const std::string& rule : options.alerts) {
+    if (!system.AddAlert(rule, error)) {
+      std::fprintf(stderr, "--alert: %s: %s\n", rule.c_str(), error.c_str());
+      return 1;
+    }
+  }
+  if (options.threads > 0) {
+    system.Threads(options.threads);
+  }
+  // events describe the live system, not another proc root
+  if (options.events && options.proc_root.empty() && !system.WatchEvents()) {
+    std::fprintf(stderr, "proc connector unavailable, scanning /proc\n");
+  }
+  if (!options.record.empty()) {
+    return Record(system, options);
+  }
+  if (!options.address.empty()) {
+    return Export(system, options);
+  }
+  if (options.headless) {
+    return Watch(system, options);
+  }
+  if (!options.replay.empty() && !system.Replay(options.replay)) {
+    std::fprintf(stderr, "%s: not a recording\n", options.replay.c_str());
+    return 1;
+  }
+  Sampler sampler(system, std::chrono::milliseconds(options.interval_ms),
+                  rows);
+  NCursesDisplay::Display(sampler, rows);
+}
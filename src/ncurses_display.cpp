@@ -1,110 +1,643 @@
 #include <curses.h>
-#include <chrono>
+#include <algorithm>
+#include <cstdio>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include "format.h"
 #include "ncurses_display.h"
+#include "process_filter.h"
+#include "self_stats.h"
 #include "system.h"
 
-using std::string;
-using std::to_string;
+using std::size_t;
+
+namespace {
+// longest line formatted for a panel, the canvas clips it to the box
+const size_t kLineSize{512};
+}  // namespace
 
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
-  int size{50};
-  float bars{percent * size};
+char* NCursesDisplay::ProgressBar(float percent, char* buffer, size_t size) {
+  int const bars{50};
+  char line[bars + 1];
+  for (int i{0}; i < bars; ++i) {
+    line[i] = i <= percent * bars ? '|' : ' ';
+  }
+  line[bars] = '\0';
+  std::snprintf(buffer, size, "0%%%s %5.1f/100%%", line, percent * 100);
+  return buffer;
+}
+
+char* NCursesDisplay::Sparkline(const std::vector<float>& points, float scale,
+                                char* buffer, size_t size) {
+  static const char levels[] = " .:-=+*#%@";
+  int const top{sizeof(levels) - 2};
+  size_t length = 0;
+  for (float point : points) {
+    if (length + 1 >= size) {
+      break;
+    }
+    int level = scale > 0 ? static_cast<int>(point / scale * top + 0.5) : 0;
+    buffer[length++] = levels[std::max(0, std::min(top, level))];
+  }
+  buffer[length] = '\0';
+  return buffer;
+}
 
-  for (int i{0}; i < size; ++i) {
-    result += i <= bars ? '|' : ' ';
+void NCursesDisplay::DisplaySystem(const Sample& sample, Canvas& canvas,
+                                   int top, int width) {
+  char line[kLineSize];
+  char bar[kLineSize];
+  int row{top};
+  auto put = [&canvas, &row, width](int column, const char* text,
+                                    attr_t attributes = A_NORMAL) {
+    canvas.Put(row, column, text, attributes, width - 1);
+  };
+  std::snprintf(line, sizeof(line), "OS: %s", sample.operating_system.c_str());
+  ++row;
+  put(2, line);
+  std::snprintf(line, sizeof(line), "Kernel: %s", sample.kernel.c_str());
+  ++row;
+  put(2, line);
+  const CpuShare& cpu = sample.cpu_shares[0];
+  ++row;
+  put(2, "CPU: ");
+  put(10, ProgressBar(cpu.utilization, bar, sizeof(bar)), COLOR_PAIR(1));
+  std::snprintf(line, sizeof(line),
+                "us %5.1f%%  sy %5.1f%%  wa %5.1f%%  st %5.1f%%",
+                cpu.user * 100, cpu.system * 100, cpu.iowait * 100,
+                cpu.steal * 100);
+  ++row;
+  put(10, line);
+  ++row;
+  put(2, "Memory: ");
+  put(10, ProgressBar(sample.system.memory_utilization, bar, sizeof(bar)),
+      COLOR_PAIR(1));
+  ++row;
+  const SystemSnapshot& memory = sample.system;
+  if (memory.memory_total_kb > 0) {
+    double const gb{1024.0 * 1024.0};
+    std::snprintf(line, sizeof(line),
+                  "avail %.1fG  buffers %.1fG  cached %.1fG  swap %.1f/%.1fG",
+                  memory.memory_available_kb / gb, memory.buffers_kb / gb,
+                  memory.cached_kb / gb,
+                  (memory.swap_total_kb - memory.swap_free_kb) / gb,
+                  memory.swap_total_kb / gb);
+    put(10, line);
   }
+  std::snprintf(line, sizeof(line), "Total Processes: %d",
+                sample.system.total_processes);
+  ++row;
+  put(2, line);
+  std::snprintf(line, sizeof(line), "Running Processes: %d",
+                sample.system.running_processes);
+  ++row;
+  put(2, line);
+  char time[16];
+  std::snprintf(line, sizeof(line), "Up Time: %s",
+                Format::ElapsedTime(sample.system.uptime, time, sizeof(time)));
+  ++row;
+  put(2, line);
+  auto trend = [&](const char* name, const SeriesStats& stats,
+                   const std::vector<float>& points) {
+    int length = std::snprintf(
+        line, sizeof(line), "%-7s 10m min %5.1f avg %5.1f max %5.1f p95 %5.1f  ",
+        name, stats.min * 100, stats.avg * 100, stats.max * 100,
+        stats.p95 * 100);
+    ++row;
+    put(2, line);
+    put(2 + length, Sparkline(points, 1.0, bar, sizeof(bar)), COLOR_PAIR(1));
+  };
+  trend("CPU%", sample.cpu_stats, sample.cpu_history);
+  trend("Mem%", sample.memory_stats, sample.memory_history);
 
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+  if (sample.replay_tick >= 0) {
+    std::snprintf(line, sizeof(line),
+                  " replay %ld/%ld %s%s, < > seek, space pause ",
+                  sample.replay_tick + 1, sample.replay_ticks,
+                  Format::DateTime(sample.replay_time_ms / 1000).c_str(),
+                  sample.paused ? " paused" : "");
+    row = top + kSystemRows - 1;
+    put(2, line);
+  }
+}
+
+// Grid of one small bar per core, kCoreCellWidth columns per core
+void NCursesDisplay::DisplayCores(const std::vector<CpuShare>& shares,
+                                  Canvas& canvas, int top, int width) {
+  int const bar_width{10};
+  int cells{std::max(1, (width - 4) / kCoreCellWidth)};
+  char bar[bar_width + 1];
+  char text[32];
+  bar[bar_width] = '\0';
+  for (size_t core = 0; core + 1 < shares.size(); ++core) {
+    float utilization = shares[core + 1].utilization;
+    for (int i = 0; i < bar_width; ++i) {
+      bar[i] = i < utilization * bar_width ? '|' : ' ';
+    }
+    int row = top + 1 + core / cells;
+    int column = 2 + (core % cells) * kCoreCellWidth;
+    std::snprintf(text, sizeof(text), "%3zu[", core);
+    canvas.Put(row, column, text, A_NORMAL, width - 1);
+    canvas.Put(row, column + 4, bar, COLOR_PAIR(1), width - 1);
+    std::snprintf(text, sizeof(text), "]%3.0f%%", utilization * 100);
+    canvas.Put(row, column + 4 + bar_width, text, A_NORMAL, width - 1);
+  }
 }
 
-void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
-  int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
-  mvwprintw(window, ++row, 2, "CPU: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, "Memory: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
-  wrefresh(window);
+int NCursesDisplay::DiskPanelRows(const std::vector<DiskRate>& disks) {
+  return disks.empty() ? 0 : 3 + std::min(kDiskRows, disks.size());
 }
 
-void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
-  int row{0};
+void NCursesDisplay::DisplayDisks(const std::vector<DiskRate>& disks,
+                                  Canvas& canvas, int top, int width) {
+  std::vector<const DiskRate*> busiest(disks.size());
+  for (size_t i = 0; i < disks.size(); ++i) {
+    busiest[i] = &disks[i];
+  }
+  size_t rows = std::min(kDiskRows, disks.size());
+  std::partial_sort(busiest.begin(), busiest.begin() + rows, busiest.end(),
+                    [](const DiskRate* a, const DiskRate* b) {
+                      return a->utilization > b->utilization;
+                    });
+  char line[kLineSize];
+  int row{top + 1};
+  std::snprintf(line, sizeof(line), "%-12s %10s %10s %8s %6s", "DEVICE",
+                "READ MB/s", "WRITE MB/s", "IOPS", "UTIL%");
+  canvas.Put(row, 2, line, COLOR_PAIR(2), width - 1);
+  double const mb{1024.0 * 1024.0};
+  for (size_t i = 0; i < rows; ++i) {
+    const DiskRate& disk = *busiest[i];
+    std::snprintf(line, sizeof(line), "%-12.12s %10.2f %10.2f %8.0f %6.1f",
+                  disk.name.c_str(), disk.read_bytes / mb,
+                  disk.write_bytes / mb, disk.iops, disk.utilization * 100);
+    canvas.Put(++row, 2, line, A_NORMAL, width - 1);
+  }
+}
+
+int NCursesDisplay::NetworkPanelRows(const NetworkRates& network) {
+  return network.count == 0 ? 0
+                            : 3 + std::min(kInterfaceRows, network.count);
+}
+
+// the TCP rates are written on the bottom border
+void NCursesDisplay::DisplayNetwork(const NetworkRates& network,
+                                    Canvas& canvas, int top, int width) {
+  const InterfaceRate* busiest[LinuxParser::kInterfaces];
+  for (size_t i = 0; i < network.count; ++i) {
+    busiest[i] = &network.interfaces[i];
+  }
+  size_t rows = std::min(kInterfaceRows, network.count);
+  std::partial_sort(busiest, busiest + rows, busiest + network.count,
+                    [](const InterfaceRate* a, const InterfaceRate* b) {
+                      return a->rx_bytes + a->tx_bytes >
+                             b->rx_bytes + b->tx_bytes;
+                    });
+  char line[kLineSize];
+  int row{top + 1};
+  std::snprintf(line, sizeof(line), "%-12s %10s %10s %9s %9s %7s %7s",
+                "INTERFACE", "RX MB/s", "TX MB/s", "RX pkt/s", "TX pkt/s",
+                "ERR/s", "DROP/s");
+  canvas.Put(row, 2, line, COLOR_PAIR(2), width - 1);
+  double const mb{1024.0 * 1024.0};
+  for (size_t i = 0; i < rows; ++i) {
+    const InterfaceRate& rate = *busiest[i];
+    std::snprintf(line, sizeof(line),
+                  "%-12.12s %10.2f %10.2f %9.0f %9.0f %7.1f %7.1f",
+                  rate.name.data(), rate.rx_bytes / mb, rate.tx_bytes / mb,
+                  rate.rx_packets, rate.tx_packets, rate.errors, rate.drops);
+    canvas.Put(++row, 2, line, A_NORMAL, width - 1);
+  }
+  float segments = network.tcp_out_segments;
+  std::snprintf(line, sizeof(line),
+                " tcp in %.0f/s out %.0f/s retransmits %.1f/s (%.2f%%) ",
+                network.tcp_in_segments, segments, network.tcp_retransmits,
+                segments > 0 ? network.tcp_retransmits / segments * 100 : 0);
+  canvas.Put(top + NetworkPanelRows(network) - 1, 2, line, A_NORMAL,
+             width - 1);
+  if (network.hidden > 0) {
+    // past the interfaces read, narrow them with --interfaces
+    std::snprintf(line, sizeof(line), " %zu more interfaces not shown ",
+                  network.hidden);
+    canvas.Put(top, 2, line, A_NORMAL, width - 1);
+  }
+}
+
+int NCursesDisplay::AlertPanelRows(const std::vector<Alert>& alerts) {
+  return alerts.empty() ? 0 : 2 + std::min(kAlertRows, alerts.size());
+}
+
+// the count of the alerts not listed is written on the bottom border
+void NCursesDisplay::DisplayAlerts(const std::vector<Alert>& alerts,
+                                   Canvas& canvas, int top, int width) {
+  char line[kLineSize];
+  size_t rows = std::min(kAlertRows, alerts.size());
+  for (size_t i = 0; i < rows; ++i) {
+    const Alert& alert = alerts[i];
+    std::string since = Format::DateTime(alert.since_ms / 1000);
+    if (alert.pid > 0) {
+      std::snprintf(line, sizeof(line), "%s  pid %-6d %-15.15s %s",
+                    since.c_str(), alert.pid, alert.command.c_str(),
+                    alert.rule.c_str());
+    } else {
+      std::snprintf(line, sizeof(line), "%s  %-26s %s", since.c_str(),
+                    "system", alert.rule.c_str());
+    }
+    canvas.Put(top + 1 + static_cast<int>(i), 2, line,
+               COLOR_PAIR(3) | A_BOLD, width - 1);
+  }
+  std::snprintf(line, sizeof(line), " alerts: %zu firing ", alerts.size());
+  canvas.Put(top, 2, line, COLOR_PAIR(3), width - 1);
+  if (alerts.size() > rows) {
+    std::snprintf(line, sizeof(line), " %zu more ", alerts.size() - rows);
+    canvas.Put(top + AlertPanelRows(alerts) - 1, 2, line, A_NORMAL,
+               width - 1);
+  }
+}
+
+// fixed width columns, a row is formatted into one line, the threads of
+// a process follow it with the TID in the PID and the state in the USER
+// column, n rows are shown in all
+void NCursesDisplay::DisplayProcesses(
+    const std::vector<ProcessSample>& processes, Canvas& canvas, int top,
+    int width, int n, SortKey key, int selected, bool tree) {
+  int row{top + 1};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
   int const ram_column{26};
-  int const time_column{35};
-  int const command_column{46};
-  wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
-  mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
-  mvwprintw(window, row, command_column, "COMMAND");
-  wattroff(window, COLOR_PAIR(2));
-  for (int i = 0; i < n; ++i) {
-    mvwprintw(window, ++row, pid_column, to_string(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
+  int const pss_column{35};
+  int const uss_column{43};
+  int const read_column{51};
+  int const write_column{60};
+  int const time_column{69};
+  int const history_column{80};
+  int const command_column{91};
+  // the column the list is sorted by is underlined
+  auto header = [&](int column, SortKey column_key, const char* title) {
+    attr_t attributes = COLOR_PAIR(2) | (column_key == key ? A_UNDERLINE : 0);
+    canvas.Put(row, column, title, attributes, width - 1);
+  };
+  header(pid_column, SortKey::kPid, "PID");
+  header(user_column, SortKey::kUser, "USER");
+  header(cpu_column, SortKey::kCpu, tree ? "CPU[%]+" : "CPU[%]");
+  header(ram_column, SortKey::kRss, tree ? "RAM[MB]+" : "RAM[MB]");
+  header(read_column, SortKey::kRead, "RD[KB/s]");
+  header(write_column, SortKey::kWrite, "WR[KB/s]");
+  header(time_column, SortKey::kUpTime, "TIME+");
+  canvas.Put(row, pss_column, "PSS[MB]", COLOR_PAIR(2), width - 1);
+  canvas.Put(row, uss_column, "USS[MB]", COLOR_PAIR(2), width - 1);
+  canvas.Put(row, history_column, "CPU 10s", COLOR_PAIR(2), width - 1);
+  canvas.Put(row, command_column, "COMMAND", COLOR_PAIR(2), width - 1);
+  char line[kLineSize];
+  char time[16];
+  char history[16];
+  char pss[16];
+  char uss[16];
+  char command[kLineSize / 2];  // indented, the rest is clipped anyway
+  // smaps_rollup is only read for the first rows, and not for processes
+  // of other users unless privileged
+  auto megabytes = [](long kb, char* buffer, size_t size) {
+    if (kb < 0) {
+      std::snprintf(buffer, size, "-");
+    } else {
+      std::snprintf(buffer, size, "%.2f", kb / 1024.0);
+    }
+    return buffer;
+  };
+  int const bottom{row + n};
+  for (size_t i = 0; i < processes.size() && row < bottom; ++i) {
+    const ProcessSample& process = processes[i];
+    float cpu = process.cpu_utilization;
+    long ram_kb = process.ram_kb;
+    const char* text = process.command.c_str();
+    if (tree) {
+      // children under their parent, a collapsed row counts what it hides
+      cpu = process.subtree_cpu;
+      ram_kb = process.subtree_rss_kb;
+      char hidden[16] = "";
+      if (process.collapsed) {
+        std::snprintf(hidden, sizeof(hidden), "[+%d] ", process.descendants);
+      }
+      std::snprintf(command, sizeof(command), "%*s%s%s%s",
+                    2 * std::max(0, process.depth - 1), "",
+                    process.depth > 0 ? "`- " : "", hidden, text);
+      text = command;
+    }
+    std::snprintf(
+        line, sizeof(line),
+        "%-6d %-6.6s %-9.2f %-8.2f %-7s %-7s %-8.0f %-8.0f %-10s %-10s %s",
+        process.pid, process.user.c_str(), cpu * 100,
+        ram_kb / 1024.0, megabytes(process.pss_kb, pss, sizeof(pss)),
+        megabytes(process.uss_kb, uss, sizeof(uss)), process.read_rate / 1024,
+        process.write_rate / 1024,
+        Format::ElapsedTime(process.uptime, time, sizeof(time)),
+        Sparkline(process.cpu_history, 1.0, history, sizeof(history)), text);
+    attr_t attributes = process.alerting ? COLOR_PAIR(3) | A_BOLD : A_NORMAL;
+    if (static_cast<int>(i) == selected) {
+      attributes |= A_REVERSE;
+    }
+    canvas.Put(++row, pid_column, line, attributes, width - 1);
+    for (size_t t = 0; t < process.threads.size() && row < bottom; ++t) {
+      const Task& task = process.threads[t];
+      bool last = t + 1 == process.threads.size();
+      std::snprintf(line, sizeof(line),
+                    "%6d %-6c %-9.2f %-8s %-7s %-7s %-8s %-8s %-10s %-10s %s %s",
+                    task.tid, task.state, task.cpu_utilization * 100, "", "",
+                    "", "", "", "", "", last ? "`-" : "|-", task.name.c_str());
+      canvas.Put(++row, pid_column, line, COLOR_PAIR(1), width - 1);
+    }
+    if (process.thread_count > process.threads.size() && row < bottom) {
+      std::snprintf(line, sizeof(line), "%*s%zu more threads",
+                    command_column - pid_column, "",
+                    process.thread_count - process.threads.size());
+      canvas.Put(++row, pid_column, line, COLOR_PAIR(1), width - 1);
+    }
+  }
+}
+
+void NCursesDisplay::DisplayCgroups(const std::vector<CgroupStats>& groups,
+                                    Canvas& canvas, int top, int width,
+                                    int n) {
+  int row{top + 1};
+  char line[kLineSize];
+  std::snprintf(line, sizeof(line), "%-6s %-9s %-10s %-9s %-6s %-6s %-6s %s",
+                "PROCS", "CPU[%]", "THROTTLED%", "MEM[MB]", "PSI cp", "PSI me",
+                "PSI io", "CGROUP");
+  canvas.Put(row, 2, line, COLOR_PAIR(2), width - 1);
+  // the path starts after the fixed columns
+  int const path_column{2 + 59};
+  char throttled[16];
+  char pressure[3][16];
+  auto percent = [](float value, char* buffer, size_t size) {
+    if (value < 0) {
+      std::snprintf(buffer, size, "-");
+    } else {
+      std::snprintf(buffer, size, "%.1f", value);
+    }
+    return buffer;
+  };
+  int room = std::max(4, width - 1 - path_column);
+  for (size_t i = 0; i < groups.size() && i < static_cast<size_t>(n); ++i) {
+    const CgroupStats& group = groups[i];
+    const char* path = group.path.c_str();
+    bool shortened = static_cast<int>(group.path.size()) > room;
+    if (shortened) {
+      path += group.path.size() - (room - 3);
+    }
+    std::snprintf(
+        line, sizeof(line), "%-6d %-9.2f %-10s %-9.1f %-6s %-6s %-6s %s%s",
+        group.processes, group.cpu_utilization * 100,
+        percent(group.throttled < 0 ? -1 : group.throttled * 100, throttled,
+                sizeof(throttled)),
+        group.memory_kb / 1024.0,
+        percent(group.cpu_pressure, pressure[0], sizeof(pressure[0])),
+        percent(group.memory_pressure, pressure[1], sizeof(pressure[1])),
+        percent(group.io_pressure, pressure[2], sizeof(pressure[2])),
+        shortened ? "..." : "", path);
+    canvas.Put(++row, 2, line, A_NORMAL, width - 1);
   }
 }
 
-void NCursesDisplay::Display(System& system, int n) {
+// Overlay of what every stage of a tick cost the monitor itself
+void NCursesDisplay::DisplaySelfStats(const Sample& sample, Canvas& canvas,
+                                      int top, int left, int width) {
+  int const height{3 + SelfStats::kStages};
+  for (int row = top; row < top + height; ++row) {
+    for (int column = left; column < left + width; ++column) {
+      canvas.Put(row, column, ' ');
+    }
+  }
+  canvas.Box(top, left, height, width);
+  int end = left + width - 1;
+  char line[kLineSize];
+  int row{top + 1};
+  std::snprintf(line, sizeof(line), "%-10s %7s %7s %7s %7s %9s %9s %8s",
+                "STAGE", "p50 ms", "p95 ms", "p99 ms", "max ms", "syscalls",
+                "KB read", "allocs");
+  canvas.Put(row, left + 2, line, COLOR_PAIR(2), end);
+  for (int stage = 0; stage < SelfStats::kStages; ++stage) {
+    const SelfStats::Summary& stats = sample.self_stats[stage];
+    std::snprintf(line, sizeof(line),
+                  "%-10s %7.2f %7.2f %7.2f %7.2f %9.0f %9.1f %8.0f",
+                  SelfStats::kStageNames[stage], stats.p50, stats.p95,
+                  stats.p99, stats.max, stats.syscalls, stats.bytes_read / 1024,
+                  stats.allocations);
+    canvas.Put(++row, left + 2, line, A_NORMAL, end);
+  }
+  std::snprintf(line, sizeof(line), " monitor cost per tick, last %ld ticks ",
+                sample.self_stats[SelfStats::kParse].ticks);
+  canvas.Put(top + height - 1, left + 2, line, A_NORMAL, end);
+}
+
+// The renderer only reads the samples published by the sampler thread,
+// it draws whenever a new one arrives, a key is pressed or the terminal
+// is resized
+void NCursesDisplay::Display(Sampler& sampler, int n) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
+  keypad(stdscr, TRUE);  // resizes arrive as KEY_RESIZE
+  curs_set(0);
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  init_pair(3, COLOR_RED, COLOR_BLACK);
+
+  Canvas canvas;
+  canvas.Resize(LINES, COLS);
+  bool show_stats{false};
+  bool sampled{false};
+  int selected{0};  // process row of the cursor
+  bool expand_top{false};
+  // the '/' prompt editing a filter, the error of the last try
+  bool prompt{false};
+  std::string input;
+  std::string error;
 
-  int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
-
-  while (1) {
-    werase(process_window);
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  timeout(50);  // getch() polls for keys between samples
+  sampler.Start();
+
+  bool running{true};
+  bool redraw{false};
+  while (running) {
+    if (sampler.Update()) {
+      sampled = true;
+      redraw = true;
+    }
+    if (redraw && sampled) {
+      SelfStats::Timer timer(SelfStats::kRender);
+      redraw = false;
+      const Sample& sample = sampler.Latest();
+      // the layout follows the size of the terminal
+      int width = canvas.Columns() - 1;
+      int cores = sample.cpu_shares.size() - 1;
+      int cells = std::max(1, (width - 4) / kCoreCellWidth);
+      int core_rows = (cores + cells - 1) / cells;
+      int cores_top = kSystemRows;
+      int disks_top = cores_top + 2 + core_rows;
+      int network_top = disks_top + DiskPanelRows(sample.disks);
+      int alerts_top = network_top + NetworkPanelRows(sample.network);
+      int process_top = alerts_top + AlertPanelRows(sample.alerts);
+      canvas.Clear();
+      canvas.Box(0, 0, kSystemRows, width);
+      canvas.Box(cores_top, 0, 2 + core_rows, width);
+      canvas.Box(process_top, 0, 3 + n, width);
+      DisplaySystem(sample, canvas, 0, width);
+      DisplayCores(sample.cpu_shares, canvas, cores_top, width);
+      if (!sample.disks.empty()) {
+        canvas.Box(disks_top, 0, DiskPanelRows(sample.disks), width);
+        DisplayDisks(sample.disks, canvas, disks_top, width);
+      }
+      if (sample.network.count > 0) {
+        canvas.Box(network_top, 0, NetworkPanelRows(sample.network), width);
+        DisplayNetwork(sample.network, canvas, network_top, width);
+      }
+      if (!sample.alerts.empty()) {
+        canvas.Box(alerts_top, 0, AlertPanelRows(sample.alerts), width);
+        DisplayAlerts(sample.alerts, canvas, alerts_top, width);
+      }
+      selected = std::min(
+          selected, std::max(0, static_cast<int>(sample.processes.size()) - 1));
+      if (sample.grouped) {
+        DisplayCgroups(sample.cgroups, canvas, process_top, width, n);
+      } else {
+        DisplayProcesses(sample.processes, canvas, process_top, width, n,
+                         sample.sort_key, selected, sample.tree);
+      }
+      if (!sample.filter.empty()) {
+        std::string title = " filter: " + sample.filter + " ";
+        canvas.Put(process_top, 2, title.c_str(), A_NORMAL, width - 1);
+      }
+      if (prompt) {
+        std::string line = " filter: " + input + "_ " + error;
+        canvas.Put(process_top + 2 + n, 2, line.c_str(), A_REVERSE,
+                   width - 1);
+      } else {
+        canvas.Put(process_top + 2 + n, 2,
+                   " sort: c cpu, m ram, r read, w write, t time, p pid,"
+                   " u user, threads: e T, g cgroups, f tree, x fold,"
+                   " / filter, s stats, q quit ",
+                   A_NORMAL, width - 1);
+      }
+      if (show_stats) {
+        DisplaySelfStats(sample, canvas, process_top + 1, 1,
+                         std::min(width - 2, 80));
+      }
+      if (canvas.Flush(stdscr)) {
+        wrefresh(stdscr);
+      }
+    }
+    int key = getch();
+    if (prompt && key != ERR && key != KEY_RESIZE) {
+      // the prompt takes every key until enter or escape, the filter
+      // is only handed to the sampler once it compiles
+      if (key == '\n' || key == KEY_ENTER) {
+        ProcessFilter filter;
+        if (ProcessFilter::Compile(input, filter, error)) {
+          sampler.FilterBy(filter);
+          prompt = false;
+        }
+      } else if (key == 27) {
+        prompt = false;
+      } else if (key == KEY_BACKSPACE || key == 127 || key == '\b') {
+        if (!input.empty()) {
+          input.pop_back();
+        }
+        error.clear();
+      } else if (key >= ' ' && key < 127) {
+        input += static_cast<char>(key);
+        error.clear();
+      }
+      redraw = true;
+      continue;
+    }
+    switch (key) {
+      case KEY_RESIZE:
+        // curses already resized stdscr, the whole screen is drawn again
+        canvas.Resize(LINES, COLS);
+        clearok(curscr, TRUE);
+        redraw = true;
+        break;
+      case 'c':
+        sampler.SortBy(SortKey::kCpu);
+        break;
+      case 'm':
+        sampler.SortBy(SortKey::kRss);
+        break;
+      case 't':
+        sampler.SortBy(SortKey::kUpTime);
+        break;
+      case 'p':
+        sampler.SortBy(SortKey::kPid);
+        break;
+      case 'u':
+        sampler.SortBy(SortKey::kUser);
+        break;
+      case 'r':
+        sampler.SortBy(SortKey::kRead);
+        break;
+      case 'w':
+        sampler.SortBy(SortKey::kWrite);
+        break;
+      case '<':
+        sampler.Seek(-kReplaySeek);
+        break;
+      case '>':
+        sampler.Seek(kReplaySeek);
+        break;
+      case ' ':
+        sampler.Pause();
+        break;
+      case KEY_UP:
+        selected = std::max(0, selected - 1);
+        redraw = true;
+        break;
+      case KEY_DOWN:
+        ++selected;  // kept on the rows when drawn
+        redraw = true;
+        break;
+      case 'e':
+      case '\n':
+      case KEY_ENTER:
+        if (sampled && selected < static_cast<int>(
+                                      sampler.Latest().processes.size())) {
+          sampler.Expand(sampler.Latest().processes[selected].pid);
+        }
+        break;
+      case 'T':
+        expand_top = !expand_top;
+        sampler.ExpandTop(expand_top ? kExpandTop : 0);
+        break;
+      case 'g':
+        sampler.GroupByCgroup();
+        break;
+      case 'f':
+        sampler.TreeView();
+        break;
+      case 'x':
+        if (sampled && sampler.Latest().tree &&
+            selected < static_cast<int>(sampler.Latest().processes.size())) {
+          sampler.Collapse(sampler.Latest().processes[selected].pid);
+        }
+        break;
+      case '/':
+        prompt = true;
+        input = sampled ? sampler.Latest().filter : std::string();
+        error.clear();
+        redraw = true;
+        break;
+      case 's':
+        show_stats = !show_stats;
+        redraw = true;
+        break;
+      case 'q':
+        running = false;
+        break;
+    }
   }
+  sampler.Stop();
   endwin();
-}
\ No newline at end of file
+}
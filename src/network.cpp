@@ -0,0 +1,62 @@
+#include <cstring>
+
+#include "network.h"
+
+using LinuxParser::InterfaceCounters;
+
+namespace {
+float Rate(uint64_t now, uint64_t before, double seconds) {
+  return now > before ? (now - before) / seconds : 0;
+}
+}  // namespace
+
+void Network::Update(const SystemSnapshot& snapshot) {
+  const LinuxParser::NetworkCounters& network = snapshot.network;
+  double seconds = snapshot.Seconds() - previous_seconds_;
+  bool first = previous_seconds_ <= 0 || seconds <= 0;
+  previous_seconds_ = snapshot.Seconds();
+  rates_.count = network.count;
+  rates_.hidden = network.hidden;
+  for (std::size_t i = 0; i < network.count; ++i) {
+    const InterfaceCounters& now = network.interfaces[i];
+    InterfaceRate& rate = rates_.interfaces[i];
+    rate = InterfaceRate{now.name};
+    // interfaces come and go, the previous line is usually at i
+    const InterfaceCounters* before = nullptr;
+    for (std::size_t j = 0; j < previous_.count && before == nullptr; ++j) {
+      const InterfaceCounters& other = previous_.interfaces[(i + j) %
+                                                            previous_.count];
+      if (std::strcmp(other.name.data(), now.name.data()) == 0) {
+        before = &other;
+      }
+    }
+    if (first || before == nullptr) {
+      continue;
+    }
+    rate.rx_bytes = Rate(now.rx_bytes, before->rx_bytes, seconds);
+    rate.tx_bytes = Rate(now.tx_bytes, before->tx_bytes, seconds);
+    rate.rx_packets = Rate(now.rx_packets, before->rx_packets, seconds);
+    rate.tx_packets = Rate(now.tx_packets, before->tx_packets, seconds);
+    rate.errors = Rate(now.rx_errors, before->rx_errors, seconds) +
+                  Rate(now.tx_errors, before->tx_errors, seconds);
+    rate.drops = Rate(now.rx_drops, before->rx_drops, seconds) +
+                 Rate(now.tx_drops, before->tx_drops, seconds);
+  }
+  if (first) {
+    rates_.tcp_in_segments = 0;
+    rates_.tcp_out_segments = 0;
+    rates_.tcp_retransmits = 0;
+  } else {
+    rates_.tcp_in_segments =
+        Rate(network.tcp_in_segments, previous_.tcp_in_segments, seconds);
+    rates_.tcp_out_segments =
+        Rate(network.tcp_out_segments, previous_.tcp_out_segments, seconds);
+    rates_.tcp_retransmits =
+        Rate(network.tcp_retransmits, previous_.tcp_retransmits, seconds);
+  }
+  previous_ = network;
+}
+
+const NetworkRates& Network::Rates() const {
+  return rates_;
+}
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "linux_parser.h"
+#include "options.h"
+
+using std::string;
+
+namespace {
+// parse a positive number, false if value is not one
+bool ParseCount(const char* value, unsigned int& count) {
+  char* end = nullptr;
+  long parsed = std::strtol(value, &end, 10);
+  if (end == value || *end != '\0' || parsed <= 0) {
+    return false;
+  }
+  count = parsed;
+  return true;
+}
+}  // namespace
+
+bool Options::Parse(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    string option{argv[i]};
+    bool has_value = i + 1 < argc;
+    if (option == "--threads" && has_value) {
+      if (!ParseCount(argv[++i], options.threads)) {
+        return false;
+      }
+    } else if (option == "--interval" && has_value) {
+      if (!ParseCount(argv[++i], options.interval_ms)) {
+        return false;
+      }
+    } else if (option == "--proc-root" && has_value) {
+      options.proc_root = argv[++i];
+    } else if (option == "--events") {
+      options.events = true;
+    } else if (option == "--record" && has_value) {
+      options.record = argv[++i];
+    } else if (option == "--replay" && has_value) {
+      options.replay = argv[++i];
+    } else if (option == "--export" && has_value) {
+      options.address = argv[++i];
+    } else if (option == "--interfaces" && has_value) {
+      options.interfaces = argv[++i];
+    } else if (option == "--filter" && has_value) {
+      options.filter = argv[++i];
+    } else if (option == "--alert" && has_value) {
+      options.alerts.push_back(argv[++i]);
+    } else if (option == "--alert-log" && has_value) {
+      options.alert_log = argv[++i];
+    } else if (option == "--alert-hook" && has_value) {
+      options.alert_hook = argv[++i];
+    } else if (option == "--headless") {
+      options.headless = true;
+    } else {
+      return false;
+    }
+  }
+  // one mode at most
+  return options.record.empty() + options.replay.empty() +
+             options.address.empty() + !options.headless >=
+         3;
+}
+
+void Options::PrintUsage(const char* program) {
+  std::fprintf(stderr,
+               "usage: %s [options]\n"
+               "  --threads N      threads sampling the processes\n"
+               "  --interval MS    refresh interval, at least 100 ms\n"
+               "  --proc-root DIR  read DIR instead of /proc\n"
+               "  --events         find processes through proc connector\n"
+               "                   events, needs CAP_NET_ADMIN\n"
+               "  --record FILE    record every tick into FILE, no display\n"
+               "  --replay FILE    show a recording, < > seek, space pauses\n"
+               "  --export ADDR    serve /metrics and /json on a localhost\n"
+               "                   port or a Unix socket path, no display\n"
+               "  --interfaces GLOBS\n"
+               "                   network interfaces shown, e.g. 'eth*,en*',\n"
+               "                   the first %zu which match\n"
+               "  --filter EXPR    list only the processes matching EXPR,\n"
+               "                   e.g. 'user==svc && cpu>1 || cmd~java'\n"
+               "  --alert RULE     alert when RULE holds, repeatable, e.g.\n"
+               "                   'cpu>90 for 30s clear cpu<80' or\n"
+               "                   'process rss_growth>50 for 2m'\n"
+               "  --alert-log FILE append the alert events of the modes\n"
+               "                   without display to FILE, not stdout\n"
+               "  --alert-hook CMD run CMD through /bin/sh on every alert\n"
+               "                   event, with MONITOR_ALERT_* variables\n"
+               "  --headless       evaluate the alerts only, no display\n",
+               program, LinuxParser::kInterfaces);
+}
@@ -0,0 +1,102 @@
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "passwd_cache.h"
+#include "proc_reader.h"
+
+using std::string;
+using std::string_view;
+
+namespace {
+// how often the passwd file is checked for changes
+const std::chrono::seconds kCheckInterval{1};
+// how long a uid unknown to NSS is shown as its number before asking again
+const std::chrono::seconds kUnknownInterval{60};
+}  // namespace
+
+PasswdCache::PasswdCache(string path) : path_(std::move(path)) {}
+
+// O(1) after the first lookup of a uid
+string PasswdCache::Name(unsigned int uid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReloadIfChanged();
+    auto found = names_.find(uid);
+    if (found != names_.end()) {
+      return found->second;
+    }
+    auto unknown = unknown_.find(uid);
+    if (unknown != unknown_.end() &&
+        std::chrono::steady_clock::now() < unknown->second) {
+      return std::to_string(uid);
+    }
+  }
+  // not in the file, ask NSS (LDAP, sssd...) without holding the lock,
+  // a slow backend only stalls the threads which need this uid
+  passwd entry;
+  passwd* result = nullptr;
+  long size = sysconf(_SC_GETPW_R_SIZE_MAX);
+  std::vector<char> buffer(size > 0 ? size : 16384);
+  bool resolved =
+      getpwuid_r(uid, &entry, buffer.data(), buffer.size(), &result) == 0 &&
+      result != nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!resolved) {
+    unknown_[uid] = std::chrono::steady_clock::now() + kUnknownInterval;
+    return std::to_string(uid);
+  }
+  unknown_.erase(uid);
+  return names_.emplace(uid, string(result->pw_name)).first->second;
+}
+
+void PasswdCache::ReloadIfChanged() {
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_check_) {
+    return;
+  }
+  next_check_ = now + kCheckInterval;
+  struct stat info;
+  if (stat(path_.c_str(), &info) != 0) {
+    return;
+  }
+  if (info.st_dev == device_ && info.st_ino == inode_ &&
+      info.st_mtim.tv_sec == mtime_.tv_sec &&
+      info.st_mtim.tv_nsec == mtime_.tv_nsec) {
+    return;
+  }
+  device_ = info.st_dev;
+  inode_ = info.st_ino;
+  mtime_ = info.st_mtim;
+  Load();
+}
+
+// name:password:uid:...
+void PasswdCache::Load() {
+  names_.clear();
+  string_view text = ProcReader::ReadPath(path_.c_str());
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    string_view line = text.substr(0, end);
+    size_t name_end = line.find(':');
+    size_t uid_start = string_view::npos;
+    if (name_end != string_view::npos) {
+      uid_start = line.find(':', name_end + 1);
+    }
+    if (uid_start != string_view::npos) {
+      string_view cursor = line.substr(uid_start + 1);
+      long uid;
+      if (ProcReader::ScanLong(cursor, uid)) {
+        // the first entry of a uid wins, like getpwuid
+        names_.emplace(uid, string(line.substr(0, name_end)));
+      }
+    }
+    if (end == string_view::npos) {
+      break;
+    }
+    text.remove_prefix(end + 1);
+  }
+}
@@ -0,0 +1,284 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <vector>
+
+#include "proc_reader.h"
+#include "self_stats.h"
+
+namespace {
+const char* const kProcRoot{"/proc"};
+const size_t kInitialBufferSize{16 * 1024};
+
+struct ThreadBuffer {
+  std::vector<char> data = std::vector<char>(kInitialBufferSize);
+  unsigned long bytes_read{0};
+  int error{0};
+};
+
+ThreadBuffer& Buffer() {
+  thread_local ThreadBuffer buffer;
+  return buffer;
+}
+
+// a root given to Root() which couldn't be opened, reads fail with
+// EBADF instead of falling back to the live /proc
+const int kFailedRoot{-2};
+std::atomic<int> root_fd{-1};
+
+// descriptor of the proc root, opened once and shared by all threads
+int ProcDirectory() {
+  int fd = root_fd.load(std::memory_order_acquire);
+  if (fd >= 0 || fd == kFailedRoot) {
+    return fd;
+  }
+  int opened = open(kProcRoot, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (!root_fd.compare_exchange_strong(fd, opened)) {
+    // another thread opened it first
+    close(opened);
+    return fd;
+  }
+  return opened;
+}
+
+// read the whole file into the thread's buffer, growing it when needed.
+// proc files are generated per read call, like procps a short read is
+// taken as the end of the file which saves the trailing read of 0 bytes
+std::string_view ReadAll(int fd) {
+  ThreadBuffer& buffer = Buffer();
+  if (fd < 0) {
+    buffer.error = errno;
+    SelfStats::CountRead(1, 0);
+    return {};
+  }
+  buffer.error = 0;
+  size_t size = 0;
+  uint64_t calls = 2;  // open and close
+  while (true) {
+    if (size == buffer.data.size()) {
+      buffer.data.resize(buffer.data.size() * 2);
+    }
+    ssize_t n = read(fd, buffer.data.data() + size, buffer.data.size() - size);
+    ++calls;
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      // files like io check the permission on read instead of open
+      buffer.error = n < 0 ? errno : 0;
+      break;
+    }
+    size += static_cast<size_t>(n);
+    if (size < buffer.data.size()) {
+      break;
+    }
+  }
+  close(fd);
+  buffer.bytes_read += size;
+  SelfStats::CountRead(calls, size);
+  return std::string_view(buffer.data.data(), size);
+}
+}  // namespace
+
+bool ProcReader::Root(const char* directory) {
+  int fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  int error = errno;
+  int previous = root_fd.exchange(fd >= 0 ? fd : kFailedRoot);
+  if (previous >= 0) {
+    close(previous);
+  }
+  errno = error;
+  return fd >= 0;
+}
+
+std::string_view ProcReader::Read(const char* relative_path) {
+  return ReadAll(openat(ProcDirectory(), relative_path, O_RDONLY | O_CLOEXEC));
+}
+
+std::string_view ProcReader::ReadPid(int pid, const char* name) {
+  char path[64];
+  char* end = FormatInt(path, pid);
+  *end++ = '/';
+  while (*name != '\0' && end < path + sizeof(path) - 1) {
+    *end++ = *name++;
+  }
+  *end = '\0';
+  return Read(path);
+}
+
+std::string_view ProcReader::ReadPath(const char* path) {
+  return ReadAll(open(path, O_RDONLY | O_CLOEXEC));
+}
+
+namespace {
+// entry of getdents64, glibc only declares it for recent versions
+struct Dirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+}  // namespace
+
+void ProcReader::Pids(std::vector<int>& pids) {
+  Pids(".", pids);
+}
+
+void ProcReader::Pids(const char* relative_directory, std::vector<int>& pids) {
+  pids.clear();
+  int fd = openat(ProcDirectory(), relative_directory,
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    SelfStats::CountRead(1, 0);
+    return;
+  }
+  alignas(Dirent64) char buffer[32 * 1024];
+  uint64_t calls = 2;  // open and close
+  uint64_t bytes = 0;
+  while (true) {
+    long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+    ++calls;
+    if (n <= 0) {
+      break;
+    }
+    bytes += n;
+    for (long offset = 0; offset < n;) {
+      const Dirent64* entry = reinterpret_cast<Dirent64*>(buffer + offset);
+      offset += entry->d_reclen;
+      if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+        continue;
+      }
+      // a PID directory is named by digits only
+      const char* name = entry->d_name;
+      int pid = 0;
+      while (*name >= '0' && *name <= '9') {
+        pid = pid * 10 + (*name++ - '0');
+      }
+      if (*name == '\0' && name != entry->d_name) {
+        pids.push_back(pid);
+      }
+    }
+  }
+  close(fd);
+  SelfStats::CountRead(calls, bytes);
+}
+
+bool ProcReader::Owner(int pid, unsigned int& uid) {
+  char name[16];
+  *FormatInt(name, pid) = '\0';
+  struct stat status;
+  bool found = fstatat(ProcDirectory(), name, &status, 0) == 0;
+  Buffer().error = found ? 0 : errno;
+  SelfStats::CountRead(1, 0);
+  if (found) {
+    uid = status.st_uid;
+  }
+  return found;
+}
+
+unsigned long ProcReader::BytesRead() {
+  return Buffer().bytes_read;
+}
+
+int ProcReader::LastError() {
+  return Buffer().error;
+}
+
+std::string_view ProcReader::NthLine(std::string_view text,
+                                     unsigned int line_no) {
+  for (unsigned int i = 0; i < line_no; ++i) {
+    size_t end = text.find('\n');
+    if (end == std::string_view::npos) {
+      return {};
+    }
+    text.remove_prefix(end + 1);
+  }
+  return text.substr(0, text.find('\n'));
+}
+
+std::string_view ProcReader::FindKey(std::string_view text,
+                                     std::string_view key) {
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    if (line.size() >= key.size() && line.compare(0, key.size(), key) == 0) {
+      // the key must be followed by a separator, "cpu" is not "cpu0"
+      bool separated = key.back() == ':' || key.back() == '=' ||
+                       line.size() == key.size() || line[key.size()] == ' ' ||
+                       line[key.size()] == '\t';
+      if (separated) {
+        return line.substr(key.size());
+      }
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    text.remove_prefix(end + 1);
+  }
+  return {};
+}
+
+long ProcReader::ValueByKey(std::string_view text, std::string_view key,
+                            long fallback) {
+  std::string_view rest = FindKey(text, key);
+  long value;
+  if (ScanLong(rest, value)) {
+    return value;
+  }
+  return fallback;
+}
+
+bool ProcReader::ParsePidStat(std::string_view text, PidStat& stat) {
+  size_t open = text.find('(');
+  size_t close = text.rfind(')');
+  if (open == std::string_view::npos || close == std::string_view::npos ||
+      close < open) {
+    return false;
+  }
+  stat.comm = text.substr(open + 1, close - open - 1);
+  std::string_view cursor = text.substr(close + 1);
+  std::string_view state = NextToken(cursor);
+  if (state.empty()) {
+    return false;
+  }
+  stat.state = state[0];
+  // fields (4) to (24), unused ones are scanned into a scratch value
+  long fields[21];
+  for (int i = 0; i < 21; ++i) {
+    if (!ScanLong(cursor, fields[i])) {
+      return false;
+    }
+  }
+  stat.ppid = fields[0];
+  stat.utime = fields[10];
+  stat.stime = fields[11];
+  stat.cutime = fields[12];
+  stat.cstime = fields[13];
+  stat.num_threads = fields[16];
+  stat.starttime = fields[18];
+  stat.rss = fields[20];
+  return true;
+}
+
+char* ProcReader::FormatInt(char* buffer, long value) {
+  char digits[24];
+  int n = 0;
+  unsigned long magnitude = value < 0 ? 0UL - static_cast<unsigned long>(value)
+                                      : static_cast<unsigned long>(value);
+  do {
+    digits[n++] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    *buffer++ = '-';
+  }
+  while (n > 0) {
+    *buffer++ = digits[--n];
+  }
+  return buffer;
+}
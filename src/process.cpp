@@ -1,5 +1,8 @@
 #include <unistd.h>
+#include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cmath>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -12,57 +15,379 @@ using std::string;
 using std::to_string;
 using std::vector;
 
-Process::Process(int pid): pid_(pid), prev_proc_cpu_time(0), prev_system_cpu_time(0) {
-  user_ = LinuxParser::User(pid);
-  command_ = LinuxParser::Command(pid);
-  CpuUtilization();
+namespace {
+// user names, commands and cgroups of every process
+StringPool& Strings() {
+  static StringPool strings;
+  return strings;
 }
+}  // namespace
+
+// fields are read by Fetch() once they are needed
+Process::Process(ProcessStore& store, std::size_t index)
+    : store_(&store), index_(index) {}
 
 // DONE: Return this process's ID
 int Process::Pid() const {
-  return pid_;
+  return store_->pid[index_];
+}
+
+// parent PID from the last refresh(), 0 in a replay
+int Process::Ppid() const {
+  return store_->ppid[index_];
+}
+
+long Process::Uid() const {
+  return store_->uid[index_];
+}
+
+const string& Process::Comm() const {
+  return store_->comm[index_];
+}
+
+char Process::State() const {
+  return store_->state[index_];
+}
+
+bool Process::Matched() const {
+  return store_->matched[index_];
+}
+
+void Process::Match(bool matched) {
+  store_->matched[index_] = matched;
 }
 
 // DONE: Return this process's CPU utilization
 float Process::CpuUtilization() {
-    return cpu_utilization_;
+    return store_->cpu_utilization[index_];
 }
 
 // DONE: Return the command that generated this process
-string Process::Command() {
-  return command_;
+const string& Process::Command() {
+  return *store_->command[index_];
+}
+
+// cgroup v2 path of the last Fetch() of kCgroupField, empty until read
+const string& Process::Cgroup() const {
+  return *store_->cgroup[index_];
 }
 
 // DONE: Return this process's memory utilization
 string Process::Ram() {
   // converting the ram to MB from KB
   std::stringstream stream;
-  stream << std::fixed << std::setprecision(2) << (LinuxParser::Ram(pid_) / 1024.0);
+  stream << std::fixed << std::setprecision(2) << (RamKb() / 1024.0);
   return stream.str();
 }
 
+// ram from the status file of the last Fetch() of kStatusField
+long Process::RamKb() {
+  return store_->ram_kb[index_];
+}
+
+// resident set size from the last refresh()
+long Process::RssKb() const {
+  static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  return store_->rss_pages[index_] * page_kb;
+}
+
+float Process::RssGrowth() const {
+  return store_->rss_growth[index_];
+}
+
+// start time in jiffies after boot
+long Process::StartTime() const {
+  return store_->start_time[index_];
+}
+
+// utime, stime, cutime and cstime from the last refresh()
+long Process::CpuJiffies() const {
+  return store_->cpu_jiffies[index_];
+}
+
+long Process::PssKb() const {
+  return store_->pss_kb[index_];
+}
+
+long Process::UssKb() const {
+  return store_->uss_kb[index_];
+}
+
+// processes of other users can't be read without CAP_SYS_PTRACE, their
+// sizes stay unknown and the read is only tried again after period_ms
+void Process::Smaps(long now_ms, long period_ms) {
+  long& smaps_ms = store_->smaps_ms[index_];
+  if (smaps_ms >= 0 && now_ms - smaps_ms < period_ms) {
+    return;
+  }
+  smaps_ms = now_ms;
+  LinuxParser::Smaps smaps;
+  if (LinuxParser::SmapsRollup(store_->pid[index_], smaps)) {
+    store_->pss_kb[index_] = smaps.pss_kb;
+    store_->uss_kb[index_] = smaps.uss_kb;
+  }
+}
+
+long Process::ReadBytes() const {
+  return store_->read_bytes[index_];
+}
+
+long Process::WriteBytes() const {
+  return store_->write_bytes[index_];
+}
+
+float Process::ReadRate() const {
+  return store_->read_rate[index_];
+}
+
+float Process::WriteRate() const {
+  return store_->write_rate[index_];
+}
+
 // DONE: Return the user (name) that generated this process
-string Process::User() {
-  return user_;
+const string& Process::User() {
+  return *store_->user[index_];
 }
 
 // DONE: Return the age of this process (in seconds)
 long int Process::UpTime() {
-  return LinuxParser::UpTime(pid_);
+  return store_->uptime[index_];
 }
 
 // DONE: Overload the "less than" comparison operator for Process objects
 bool Process::operator<(Process const& a) const {
-  return cpu_utilization_ > a.cpu_utilization_;
-}
-void Process::refresh() {
-//  long total_time = LinuxParser::ActiveJiffies(pid_);
-//  cpu_utilization_ = 100.0 * ((total_time / float(sysconf(_SC_CLK_TCK))) / float(LinuxParser::UpTime(pid_)));
-//  return cpu_utilization_;
-  long system_cpu_time = LinuxParser::ActiveJiffies();
-  long proc_cpu_time = LinuxParser::ActiveJiffies(pid_);
-  cpu_utilization_ = 100.0 * (float(proc_cpu_time) - prev_proc_cpu_time);
-  cpu_utilization_ /= (float(system_cpu_time) - prev_system_cpu_time);
-  prev_proc_cpu_time = proc_cpu_time;
-  prev_system_cpu_time = system_cpu_time;
+  return store_->cpu_utilization[index_] > a.store_->cpu_utilization[a.index_];
+}
+
+// Ordering of the process list for the given sort key, the first
+// process is shown at the top
+bool Process::Before(Process const& a, SortKey key) const {
+  switch (key) {
+    case SortKey::kRss:
+      return store_->rss_pages[index_] > a.store_->rss_pages[a.index_];
+    case SortKey::kUpTime:
+      return store_->start_time[index_] < a.store_->start_time[a.index_];
+    case SortKey::kPid:
+      return store_->pid[index_] < a.store_->pid[a.index_];
+    case SortKey::kUser:
+      // pooled, equal names share their copy
+      return store_->user[index_] != a.store_->user[a.index_] &&
+             *store_->user[index_] < *a.store_->user[a.index_];
+    case SortKey::kRead:
+      return store_->read_rate[index_] > a.store_->read_rate[a.index_];
+    case SortKey::kWrite:
+      return store_->write_rate[index_] > a.store_->write_rate[a.index_];
+    case SortKey::kCpu:
+      break;
+  }
+  return *this < a;
+}
+
+bool Process::Numeric(SortKey key) {
+  return key != SortKey::kUser;
+}
+
+// ascending in the order of Before(), the values of the numeric keys fit
+// a double exactly
+double Process::SortValue(SortKey key) const {
+  switch (key) {
+    case SortKey::kRss:
+      return -store_->rss_pages[index_];
+    case SortKey::kUpTime:
+      return store_->start_time[index_];
+    case SortKey::kPid:
+      return store_->pid[index_];
+    case SortKey::kRead:
+      return -store_->read_rate[index_];
+    case SortKey::kWrite:
+      return -store_->write_rate[index_];
+    case SortKey::kUser:
+    case SortKey::kCpu:
+      break;
+  }
+  return -store_->cpu_utilization[index_];
+}
+
+// system cpu time comes from the tick's snapshot, only the
+// process's own stat file is read here
+void Process::refresh(const SystemSnapshot& snapshot) {
+  ProcReader::PidStat stat;
+  if (!LinuxParser::ProcessStat(store_->pid[index_], stat)) {
+    store_->cpu_utilization[index_] = 0.0;
+    return;
+  }
+  if (Sample(snapshot, stat.starttime,
+             stat.utime + stat.stime + stat.cutime + stat.cstime)) {
+    store_->known[index_] = 0;
+    store_->pss_kb[index_] = -1;
+    store_->uss_kb[index_] = -1;
+    store_->smaps_ms[index_] = -1;
+    store_->prev_io_seconds[index_] = 0;
+    store_->prev_rss_seconds[index_] = 0;
+    store_->rss_growth[index_] = 0;
+    store_->io_denied[index_] = false;
+  }
+  SampleRss(snapshot, stat.rss);
+  store_->ppid[index_] = stat.ppid;
+  store_->state[index_] = stat.state;
+  store_->comm[index_].assign(stat.comm.data(), stat.comm.size());
+}
+
+// a set-user-ID program may change who can read the io file
+void Process::Exec() {
+  store_->known[index_] = 0;
+  store_->io_denied[index_] = false;
+}
+
+unsigned int Process::Fields(SortKey key) {
+  switch (key) {
+    case SortKey::kPid:
+      return 0;
+    case SortKey::kUser:
+      return kUserField;
+    case SortKey::kRead:
+    case SortKey::kWrite:
+      return kIoField;
+    case SortKey::kCpu:
+    case SortKey::kRss:
+    case SortKey::kUpTime:
+      break;
+  }
+  return kStatField;
+}
+
+void Process::Fetch(unsigned int fields, const SystemSnapshot& snapshot,
+                    unsigned int tick) {
+  if ((fields & kStatField) != 0 && store_->stat_tick[index_] != tick) {
+    store_->stat_tick[index_] = tick;
+    refresh(snapshot);
+  }
+  unsigned int missing = fields & ~store_->known[index_];
+  if ((missing & kUserField) != 0) {
+    store_->uid[index_] = LinuxParser::Owner(store_->pid[index_]);
+    store_->user[index_] =
+        Strings().Intern(LinuxParser::UserName(store_->uid[index_]));
+  }
+  if ((missing & kCommandField) != 0) {
+    store_->command[index_] =
+        Strings().Intern(LinuxParser::Command(store_->pid[index_]));
+  }
+  unsigned int known = fields & (kUserField | kCommandField | kCgroupField);
+  if ((missing & kCgroupField) != 0) {
+    store_->cgroup[index_] =
+        Strings().Intern(LinuxParser::Cgroup(store_->pid[index_]));
+    // a race with exit or a denied read, read again next tick
+    if (store_->cgroup[index_]->empty()) {
+      known &= ~kCgroupField;
+    }
+  }
+  store_->known[index_] |= known;
+  if ((fields & kStatusField) != 0 && store_->status_tick[index_] != tick) {
+    store_->status_tick[index_] = tick;
+    store_->ram_kb[index_] = LinuxParser::Ram(store_->pid[index_]);
+  }
+  if ((fields & kIoField) != 0 && store_->io_tick[index_] != tick &&
+      !store_->io_denied[index_]) {
+    store_->io_tick[index_] = tick;
+    SampleIo(snapshot);
+  }
+}
+
+// the byte counters over the seconds of the snapshots, like the cpu time
+// over the jiffies in Sample(). The io file of another user's process
+// needs CAP_SYS_PTRACE, a denied read is not tried again every tick
+void Process::SampleIo(const SystemSnapshot& snapshot) {
+  LinuxParser::Io io;
+  if (!LinuxParser::ProcessIo(store_->pid[index_], io)) {
+    store_->io_denied[index_] = ProcReader::LastError() == EACCES;
+    store_->read_rate[index_] = 0;
+    store_->write_rate[index_] = 0;
+    return;
+  }
+  double seconds = snapshot.Seconds();
+  double& prev_seconds = store_->prev_io_seconds[index_];
+  double delta = seconds - prev_seconds;
+  uint64_t& read_bytes = store_->read_bytes[index_];
+  uint64_t& write_bytes = store_->write_bytes[index_];
+  float& read_rate = store_->read_rate[index_];
+  float& write_rate = store_->write_rate[index_];
+  uint64_t read = io.read_bytes;
+  uint64_t written = io.write_bytes;
+  read_rate = 0;
+  write_rate = 0;
+  if (prev_seconds > 0 && delta > 0) {
+    if (read > read_bytes) {
+      read_rate = (read - read_bytes) / delta;
+    }
+    if (written > write_bytes) {
+      write_rate = (written - write_bytes) / delta;
+    }
+  }
+  read_bytes = read;
+  write_bytes = written;
+  prev_seconds = seconds;
+}
+
+// allocators grow the heap in steps, a moving average over about a
+// minute turns the steps of a leak into a steady rate
+void Process::SampleRss(const SystemSnapshot& snapshot, long rss_pages) {
+  static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  double seconds = snapshot.Seconds();
+  double& prev_seconds = store_->prev_rss_seconds[index_];
+  double delta = seconds - prev_seconds;
+  if (prev_seconds > 0 && delta > 0) {
+    float rate = (rss_pages - store_->rss_pages[index_]) * page_kb / delta;
+    float weight = 1 - std::exp(-delta / 60);
+    float& growth = store_->rss_growth[index_];
+    growth += weight * (rate - growth);
+  }
+  store_->rss_pages[index_] = rss_pages;
+  prev_seconds = seconds;
+}
+
+void Process::refresh(const SystemSnapshot& snapshot,
+                      const ProcessRecord& record) {
+  static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  if (Sample(snapshot, record.start_time, record.cpu_jiffies)) {
+    store_->prev_rss_seconds[index_] = 0;
+    store_->rss_growth[index_] = 0;
+  }
+  // a recorded process keeps its user and command from tick to tick
+  if (*store_->user[index_] != record.user) {
+    store_->user[index_] = Strings().Intern(record.user);
+  }
+  if (*store_->command[index_] != record.command) {
+    store_->command[index_] = Strings().Intern(record.command);
+  }
+  store_->known[index_] = kUserField | kCommandField;
+  SampleRss(snapshot, record.rss_kb / page_kb);
+  store_->ram_kb[index_] = record.rss_kb;
+}
+
+bool Process::Sample(const SystemSnapshot& snapshot, long start_time,
+                     uint64_t cpu_jiffies) {
+  static const long ticks = sysconf(_SC_CLK_TCK);
+  uint64_t& prev_cpu_jiffies = store_->prev_cpu_jiffies[index_];
+  uint64_t& prev_total_jiffies = store_->prev_total_jiffies[index_];
+  bool started = start_time != store_->start_time[index_];
+  if (started) {
+    // first sample, or the PID now belongs to another process
+    // whose previous samples must be dropped
+    prev_cpu_jiffies = 0;
+    prev_total_jiffies = 0;
+    store_->start_time[index_] = start_time;
+  }
+  store_->cpu_jiffies[index_] = cpu_jiffies;
+  store_->uptime[index_] = snapshot.uptime - start_time / ticks;
+  // the deltas are taken in integers, only their ratio is a float
+  uint64_t total_jiffies = snapshot.total_jiffies;
+  float& cpu_utilization = store_->cpu_utilization[index_];
+  cpu_utilization = 0.0;
+  if (total_jiffies > prev_total_jiffies && cpu_jiffies >= prev_cpu_jiffies) {
+    cpu_utilization = static_cast<double>(cpu_jiffies - prev_cpu_jiffies) /
+                      (total_jiffies - prev_total_jiffies);
+  }
+  prev_cpu_jiffies = cpu_jiffies;
+  prev_total_jiffies = total_jiffies;
+  return started;
 }
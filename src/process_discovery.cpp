@@ -0,0 +1,180 @@
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "proc_reader.h"
+#include "process_discovery.h"
+#include "self_stats.h"
+
+using std::vector;
+
+namespace {
+// room for bursts of events between two ticks
+const int kReceiveBuffer{1 << 20};
+// time the kernel has to acknowledge the subscription
+const int kAckTimeoutMs{200};
+
+// a netlink message carrying a connector message to the proc connector
+bool Send(int fd, proc_cn_mcast_op op) {
+  alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(op))];
+  std::memset(buffer, 0, sizeof(buffer));
+  nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+  header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(op));
+  header->nlmsg_type = NLMSG_DONE;
+  header->nlmsg_pid = getpid();
+  cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->len = sizeof(op);
+  std::memcpy(message->data, &op, sizeof(op));
+  return send(fd, buffer, header->nlmsg_len, 0) ==
+         static_cast<ssize_t>(header->nlmsg_len);
+}
+}  // namespace
+
+constexpr std::chrono::seconds ProcessDiscovery::kRescanInterval;
+
+ProcessDiscovery::~ProcessDiscovery() {
+  Close();
+}
+
+// binding to the multicast group needs CAP_NET_ADMIN, and the kernel
+// answers the subscription with an acknowledgement carrying an error,
+// or not at all inside a user or PID namespace
+bool ProcessDiscovery::Listen() {
+  if (socket_ >= 0) {
+    return true;
+  }
+  socket_ = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                   NETLINK_CONNECTOR);
+  if (socket_ < 0) {
+    return false;
+  }
+  setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &kReceiveBuffer,
+             sizeof(kReceiveBuffer));
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+          0 ||
+      !Send(socket_, PROC_CN_MCAST_LISTEN)) {
+    Close();
+    return false;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(kAckTimeoutMs);
+  alignas(nlmsghdr) char buffer[4096];
+  while (true) {
+    int left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   deadline - std::chrono::steady_clock::now())
+                   .count();
+    pollfd polled{socket_, POLLIN, 0};
+    if (left <= 0 || poll(&polled, 1, left) <= 0) {
+      Close();
+      return false;
+    }
+    ssize_t length = recv(socket_, buffer, sizeof(buffer), 0);
+    if (length <= 0) {
+      continue;
+    }
+    nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+    for (int left_bytes = length; NLMSG_OK(header, left_bytes);
+         header = NLMSG_NEXT(header, left_bytes)) {
+      cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+      proc_event* event = reinterpret_cast<proc_event*>(message->data);
+      if (event->what == proc_event::PROC_EVENT_NONE) {
+        if (event->event_data.ack.err != 0) {
+          Close();
+          return false;
+        }
+        // the set is filled by the first scan
+        rescan_ = std::chrono::steady_clock::time_point();
+        return true;
+      }
+    }
+  }
+}
+
+bool ProcessDiscovery::Listening() const {
+  return socket_ >= 0;
+}
+
+void ProcessDiscovery::Close() {
+  if (socket_ >= 0) {
+    Send(socket_, PROC_CN_MCAST_IGNORE);
+    close(socket_);
+    socket_ = -1;
+  }
+}
+
+// apply the events received since the last call, false when events
+// were lost and the set must be rescanned
+bool ProcessDiscovery::Drain(vector<int>& execs) {
+  alignas(nlmsghdr) char buffer[64 * 1024];
+  uint64_t calls = 0;
+  uint64_t bytes = 0;
+  bool complete = true;
+  while (true) {
+    ssize_t length = recv(socket_, buffer, sizeof(buffer), 0);
+    ++calls;
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // ENOBUFS: the receive buffer overflowed
+      complete = errno == EAGAIN || errno == EWOULDBLOCK;
+      break;
+    }
+    bytes += length;
+    nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+    for (int left = length; NLMSG_OK(header, left);
+         header = NLMSG_NEXT(header, left)) {
+      cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+      const proc_event* event = reinterpret_cast<proc_event*>(message->data);
+      switch (event->what) {
+        case proc_event::PROC_EVENT_FORK:
+          // threads are forks within the thread group
+          if (event->event_data.fork.child_pid ==
+              event->event_data.fork.child_tgid) {
+            pids_.insert(event->event_data.fork.child_tgid);
+          }
+          break;
+        case proc_event::PROC_EVENT_EXEC:
+          execs.push_back(event->event_data.exec.process_tgid);
+          break;
+        case proc_event::PROC_EVENT_EXIT:
+          if (event->event_data.exit.process_pid ==
+              event->event_data.exit.process_tgid) {
+            pids_.erase(event->event_data.exit.process_tgid);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  SelfStats::CountRead(calls, bytes);
+  return complete;
+}
+
+void ProcessDiscovery::Pids(vector<int>& pids, vector<int>& execs) {
+  execs.clear();
+  if (socket_ < 0) {
+    ProcReader::Pids(pids);
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (!Drain(execs) || now >= rescan_) {
+    ProcReader::Pids(scan_);
+    pids_.clear();
+    pids_.insert(scan_.begin(), scan_.end());
+    rescan_ = now + kRescanInterval;
+  }
+  pids.assign(pids_.begin(), pids_.end());
+}
@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include "process_filter.h"
+
+using std::string;
+using std::vector;
+
+// recursive descent over the tokens of the text, one token ahead
+class ProcessFilter::Parser {
+ public:
+  Parser(const string& text, vector<Node>& nodes)
+      : text_(text), nodes_(nodes) {}
+
+  bool Parse(int& root, string& error) {
+    Advance();
+    root = -1;
+    if (token_ != Token::kEnd) {
+      root = Or();
+      if (root >= 0 && token_ != Token::kEnd) {
+        root = Fail("expected && or ||");
+      }
+    }
+    error = error_;
+    return error_.empty();
+  }
+
+ private:
+  enum class Token {
+    kEnd,
+    kWord,
+    kAnd,
+    kOr,
+    kNot,
+    kOpen,
+    kClose,
+    kOperator,
+    kBad
+  };
+
+  // what a field costs to read, cheapest first: nothing for the PID, a
+  // stat of the PID directory, the stat file, the status file, files
+  // read once per process and the io file
+  struct FieldInfo {
+    const char* name;
+    Field field;
+    unsigned int fields;
+    int cost;
+    bool numeric;
+  };
+  static const FieldInfo* Lookup(const string& name) {
+    static const FieldInfo kFields[] = {
+        {"pid", Field::kPid, 0, 0, true},
+        {"uid", Field::kUid, kUserField, 1, true},
+        {"user", Field::kUser, kUserField, 1, false},
+        {"ppid", Field::kPpid, kStatField, 2, true},
+        {"comm", Field::kComm, kStatField, 2, false},
+        {"state", Field::kState, kStatField, 2, false},
+        {"cpu", Field::kCpu, kStatField, 2, true},
+        {"rss", Field::kRss, kStatField, 2, true},
+        {"rss_growth", Field::kRssGrowth, kStatField, 2, true},
+        {"time", Field::kTime, kStatField, 2, true},
+        {"ram", Field::kRam, kStatusField, 3, true},
+        {"cmd", Field::kCommand, kCommandField, 4, false},
+        {"cgroup", Field::kCgroup, kCgroupField, 4, false},
+        {"read", Field::kRead, kIoField, 5, true},
+        {"write", Field::kWrite, kIoField, 5, true},
+    };
+    for (const FieldInfo& info : kFields) {
+      if (name == info.name) {
+        return &info;
+      }
+    }
+    return nullptr;
+  }
+
+  void Advance() {
+    while (position_ < text_.size() && text_[position_] == ' ') {
+      ++position_;
+    }
+    start_ = position_;
+    if (position_ >= text_.size()) {
+      token_ = Token::kEnd;
+      return;
+    }
+    char c = text_[position_];
+    char next = position_ + 1 < text_.size() ? text_[position_ + 1] : '\0';
+    auto take = [this](Token token, size_t length) {
+      token_ = token;
+      position_ += length;
+    };
+    auto compare = [this, &take](Operator op, size_t length) {
+      op_ = op;
+      take(Token::kOperator, length);
+    };
+    if (c == '&' && next == '&') {
+      take(Token::kAnd, 2);
+    } else if (c == '|' && next == '|') {
+      take(Token::kOr, 2);
+    } else if (c == '=' && next == '=') {
+      compare(Operator::kEqual, 2);
+    } else if (c == '!' && next == '=') {
+      compare(Operator::kNotEqual, 2);
+    } else if (c == '!' && next == '~') {
+      compare(Operator::kNotContains, 2);
+    } else if (c == '<') {
+      next == '=' ? compare(Operator::kLessEqual, 2)
+                  : compare(Operator::kLess, 1);
+    } else if (c == '>') {
+      next == '=' ? compare(Operator::kGreaterEqual, 2)
+                  : compare(Operator::kGreater, 1);
+    } else if (c == '~') {
+      compare(Operator::kContains, 1);
+    } else if (c == '!') {
+      take(Token::kNot, 1);
+    } else if (c == '(') {
+      take(Token::kOpen, 1);
+    } else if (c == ')') {
+      take(Token::kClose, 1);
+    } else if (c == '"') {
+      size_t end = text_.find('"', position_ + 1);
+      if (end == string::npos) {
+        token_ = Token::kBad;
+        return;
+      }
+      word_ = text_.substr(position_ + 1, end - position_ - 1);
+      take(Token::kWord, end + 1 - position_);
+    } else {
+      size_t end = position_;
+      while (end < text_.size() && text_[end] != ' ' &&
+             std::strchr("&|!=<>~()\"", text_[end]) == nullptr) {
+        ++end;
+      }
+      if (end == position_) {
+        token_ = Token::kBad;
+        return;
+      }
+      word_ = text_.substr(position_, end - position_);
+      take(Token::kWord, end - position_);
+    }
+  }
+
+  // -1 with the message and the column of the token
+  int Fail(const char* message) {
+    if (error_.empty()) {
+      char column[32];
+      std::snprintf(column, sizeof(column), " at column %zu", start_ + 1);
+      if (token_ != Token::kBad) {
+        error_ = message;
+      } else if (text_[start_] == '"') {
+        error_ = "missing closing \"";
+      } else {
+        error_ = "unexpected character";
+      }
+      error_ += column;
+    }
+    return -1;
+  }
+
+  int Add(Node node) {
+    nodes_.push_back(std::move(node));
+    return nodes_.size() - 1;
+  }
+
+  // the cheapest operands are evaluated first, their order doesn't
+  // change the result as the predicates have no side effects
+  int Join(Kind kind, vector<int> operands) {
+    if (operands.size() == 1) {
+      return operands[0];
+    }
+    std::stable_sort(operands.begin(), operands.end(), [this](int a, int b) {
+      return nodes_[a].cost < nodes_[b].cost;
+    });
+    Node node;
+    node.kind = kind;
+    for (int operand : operands) {
+      node.fields |= nodes_[operand].fields;
+      node.cost = std::max(node.cost, nodes_[operand].cost);
+    }
+    node.operands = std::move(operands);
+    return Add(std::move(node));
+  }
+
+  int Or() {
+    vector<int> operands{And()};
+    while (operands.back() >= 0 && token_ == Token::kOr) {
+      Advance();
+      operands.push_back(And());
+    }
+    return operands.back() < 0 ? -1 : Join(Kind::kAny, std::move(operands));
+  }
+
+  int And() {
+    vector<int> operands{Unary()};
+    while (operands.back() >= 0 && token_ == Token::kAnd) {
+      Advance();
+      operands.push_back(Unary());
+    }
+    return operands.back() < 0 ? -1 : Join(Kind::kAll, std::move(operands));
+  }
+
+  int Unary() {
+    if (token_ == Token::kNot) {
+      Advance();
+      int operand = Unary();
+      if (operand < 0) {
+        return -1;
+      }
+      Node node;
+      node.kind = Kind::kNot;
+      node.operands.push_back(operand);
+      node.fields = nodes_[operand].fields;
+      node.cost = nodes_[operand].cost;
+      return Add(std::move(node));
+    }
+    if (token_ == Token::kOpen) {
+      Advance();
+      int expression = Or();
+      if (expression < 0) {
+        return -1;
+      }
+      if (token_ != Token::kClose) {
+        return Fail("expected )");
+      }
+      Advance();
+      return expression;
+    }
+    return Test();
+  }
+
+  int Test() {
+    if (token_ != Token::kWord) {
+      return Fail("expected a field");
+    }
+    const FieldInfo* info = Lookup(word_);
+    if (info == nullptr) {
+      return Fail("unknown field");
+    }
+    Node node;
+    node.field = info->field;
+    node.fields = info->fields;
+    node.cost = info->cost;
+    node.numeric = info->numeric;
+    Advance();
+    if (token_ != Token::kOperator) {
+      return Fail("expected == != < <= > >= ~ or !~");
+    }
+    node.op = op_;
+    bool contains =
+        op_ == Operator::kContains || op_ == Operator::kNotContains;
+    bool ordered = op_ != Operator::kEqual && op_ != Operator::kNotEqual &&
+                   !contains;
+    if (node.numeric && contains) {
+      return Fail("~ compares text");
+    }
+    if (!node.numeric && ordered) {
+      return Fail("< and > compare numbers");
+    }
+    Advance();
+    if (token_ != Token::kWord) {
+      return Fail("expected a value");
+    }
+    node.text = word_;
+    if (node.numeric) {
+      char* end = nullptr;
+      node.number = std::strtod(word_.c_str(), &end);
+      if (end == word_.c_str() || *end != '\0') {
+        return Fail("expected a number");
+      }
+    }
+    Advance();
+    return Add(std::move(node));
+  }
+
+  const string& text_;
+  vector<Node>& nodes_;
+  size_t position_{0};
+  size_t start_{0};  // of the current token
+  Token token_{Token::kEnd};
+  string word_;
+  Operator op_{Operator::kEqual};
+  string error_;
+};
+
+bool ProcessFilter::Compile(const string& text, ProcessFilter& filter,
+                            string& error) {
+  ProcessFilter compiled;
+  compiled.text_ = text;
+  Parser parser(text, compiled.nodes_);
+  if (!parser.Parse(compiled.root_, error)) {
+    return false;
+  }
+  filter = std::move(compiled);
+  return true;
+}
+
+bool ProcessFilter::Empty() const {
+  return root_ < 0;
+}
+
+const string& ProcessFilter::Text() const {
+  return text_;
+}
+
+// units as the display shows them
+bool ProcessFilter::Test(const Node& node, Process& process) {
+  double number = 0;
+  // the text fields are read in place, the pooled ones aren't copied
+  std::string_view text;
+  char state = '?';
+  switch (node.field) {
+    case Field::kPid:
+      number = process.Pid();
+      break;
+    case Field::kPpid:
+      number = process.Ppid();
+      break;
+    case Field::kUid:
+      number = process.Uid();
+      break;
+    case Field::kUser:
+      text = process.User();
+      break;
+    case Field::kComm:
+      text = process.Comm();
+      break;
+    case Field::kState:
+      state = process.State();
+      text = std::string_view(&state, 1);
+      break;
+    case Field::kCommand:
+      text = process.Command();
+      break;
+    case Field::kCgroup:
+      text = process.Cgroup();
+      break;
+    case Field::kCpu:
+      number = process.CpuUtilization() * 100;
+      break;
+    case Field::kRss:
+      number = process.RssKb() / 1024.0;
+      break;
+    case Field::kRssGrowth:
+      number = process.RssGrowth() * 60 / 1024;
+      break;
+    case Field::kRam:
+      number = process.RamKb() / 1024.0;
+      break;
+    case Field::kRead:
+      number = process.ReadRate() / 1024;
+      break;
+    case Field::kWrite:
+      number = process.WriteRate() / 1024;
+      break;
+    case Field::kTime:
+      number = process.UpTime();
+      break;
+  }
+  switch (node.op) {
+    case Operator::kEqual:
+      return node.numeric ? number == node.number : text == node.text;
+    case Operator::kNotEqual:
+      return node.numeric ? number != node.number : text != node.text;
+    case Operator::kLess:
+      return number < node.number;
+    case Operator::kLessEqual:
+      return number <= node.number;
+    case Operator::kGreater:
+      return number > node.number;
+    case Operator::kGreaterEqual:
+      return number >= node.number;
+    case Operator::kContains:
+      return text.find(node.text) != std::string_view::npos;
+    case Operator::kNotContains:
+      return text.find(node.text) == std::string_view::npos;
+  }
+  return false;
+}
@@ -0,0 +1,33 @@
+#include <utility>
+
+#include "process_store.h"
+
+std::size_t ProcessStore::Size() const {
+  return pid.size();
+}
+
+std::size_t ProcessStore::Add(int process) {
+  Columns([](auto& column) { column.emplace_back(); });
+  pid.back() = process;
+  uid.back() = -1;
+  user.back() = StringPool::Empty();
+  command.back() = StringPool::Empty();
+  cgroup.back() = StringPool::Empty();
+  start_time.back() = -1;
+  pss_kb.back() = -1;
+  uss_kb.back() = -1;
+  smaps_ms.back() = -1;
+  state.back() = '?';
+  matched.back() = true;
+  return pid.size() - 1;
+}
+
+void ProcessStore::Remove(std::size_t index) {
+  std::size_t last = pid.size() - 1;
+  Columns([index, last](auto& column) {
+    if (index != last) {
+      column[index] = std::move(column[last]);
+    }
+    column.pop_back();
+  });
+}
@@ -0,0 +1,111 @@
+#include "process_table.h"
+
+using std::vector;
+
+std::vector<Process>& ProcessTable::Processes() {
+  return processes_;
+}
+
+Process* ProcessTable::Lookup(int pid) {
+  int index = slots_.empty() ? kEmpty : Find(pid);
+  return index == kEmpty ? nullptr : &processes_[index];
+}
+
+void ProcessTable::Update(const vector<int>& pids) {
+  // at most every known and every listed PID is indexed during the tick,
+  // keep the load factor under 1/2 for them
+  size_t entries = pids.size() + store_.Size();
+  if (slots_.size() < 2 * entries) {
+    size_t capacity = 64;
+    while (capacity < 4 * entries) {
+      capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{});
+    for (size_t i = 0; i < store_.Size(); ++i) {
+      Insert(store_.pid[i], i);
+    }
+  }
+
+  ++generation_;
+  for (int pid : pids) {
+    int index = Find(pid);
+    if (index == kEmpty) {
+      // birth
+      index = store_.Add(pid);
+      processes_.emplace_back(store_, index);
+      generations_.push_back(generation_);
+      Insert(pid, index);
+    } else {
+      generations_[index] = generation_;
+    }
+  }
+
+  // deaths, the last row is moved into the freed one, and the view of
+  // the last row is dropped
+  for (size_t i = 0; i < store_.Size();) {
+    if (generations_[i] == generation_) {
+      ++i;
+      continue;
+    }
+    Erase(store_.pid[i]);
+    size_t last = store_.Size() - 1;
+    store_.Remove(i);
+    if (i != last) {
+      generations_[i] = generations_[last];
+      slots_[Locate(store_.pid[i])].index = i;
+    }
+    processes_.pop_back();
+    generations_.pop_back();
+  }
+}
+
+void ProcessTable::Clear() {
+  store_ = ProcessStore();
+  processes_.clear();
+  generations_.clear();
+  slots_.clear();
+}
+
+size_t ProcessTable::Home(int pid) const {
+  // Fibonacci hashing spreads sequential PIDs over the table
+  unsigned int hash = static_cast<unsigned int>(pid) * 2654435769u;
+  return hash & (slots_.size() - 1);
+}
+
+// slot holding pid, or the empty slot ending its probe sequence
+size_t ProcessTable::Locate(int pid) const {
+  size_t i = Home(pid);
+  while (slots_[i].pid != pid && slots_[i].pid != kEmpty) {
+    i = (i + 1) & (slots_.size() - 1);
+  }
+  return i;
+}
+
+int ProcessTable::Find(int pid) const {
+  const Slot& slot = slots_[Locate(pid)];
+  return slot.pid == pid ? slot.index : kEmpty;
+}
+
+void ProcessTable::Insert(int pid, int index) {
+  slots_[Locate(pid)] = Slot{pid, index};
+}
+
+// backward shift deletion keeps the probe sequences without tombstones
+void ProcessTable::Erase(int pid) {
+  size_t mask = slots_.size() - 1;
+  size_t i = Locate(pid);
+  if (slots_[i].pid != pid) {
+    return;
+  }
+  size_t next = (i + 1) & mask;
+  while (slots_[next].pid != kEmpty) {
+    size_t home = Home(slots_[next].pid);
+    // the entry may move back unless its home lies inside (i, next]
+    if (((next - home) & mask) >= ((next - i) & mask)) {
+      slots_[i] = slots_[next];
+      i = next;
+    }
+    next = (next + 1) & mask;
+  }
+  slots_[i] = Slot{};
+}
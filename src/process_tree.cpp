@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "process_tree.h"
+
+using std::size_t;
+using std::vector;
+
+void ProcessTree::Update(vector<Process>& processes) {
+  ++generation_;
+  for (size_t i = 0; i < processes.size(); ++i) {
+    int pid = processes[i].Pid();
+    Node& node = nodes_[pid];
+    node.pid = pid;
+    node.index = i;
+    node.generation = generation_;
+  }
+
+  // deaths, the kernel moves their children to a reaper and the new
+  // parent PID is linked below once their stat file shows it
+  for (auto entry = nodes_.begin(); entry != nodes_.end();) {
+    Node& node = entry->second;
+    if (node.generation == generation_) {
+      ++entry;
+      continue;
+    }
+    Unlink(node);
+    for (Node* child : node.children) {
+      child->parent = nullptr;
+    }
+    entry = nodes_.erase(entry);
+  }
+
+  // births and reparented processes, a process whose parent isn't listed
+  // stays a root and its parent is looked up again next tick
+  roots_.clear();
+  for (auto& entry : nodes_) {
+    Node& node = entry.second;
+    int ppid = processes[node.index].Ppid();
+    if (ppid != node.ppid || (node.parent == nullptr && ppid != 0)) {
+      Unlink(node);
+      node.ppid = ppid;
+      auto parent = nodes_.find(ppid);
+      if (parent != nodes_.end() && ppid != node.pid) {
+        node.parent = &parent->second;
+        node.parent->children.push_back(&node);
+      }
+    }
+    if (node.parent == nullptr) {
+      roots_.push_back(&node);
+    }
+  }
+
+  // breadth first from the roots, then the subtrees are summed backwards
+  // so every child is added before its parent is
+  order_.assign(roots_.begin(), roots_.end());
+  for (size_t i = 0; i < order_.size(); ++i) {
+    order_.insert(order_.end(), order_[i]->children.begin(),
+                  order_[i]->children.end());
+  }
+  for (auto node = order_.rbegin(); node != order_.rend(); ++node) {
+    Node& sum = **node;
+    Process& process = processes[sum.index];
+    sum.cpu_utilization = process.CpuUtilization();
+    sum.rss_kb = process.RssKb();
+    sum.descendants = 0;
+    sum.matches = process.Matched() ? 1 : 0;
+    for (const Node* child : sum.children) {
+      sum.matches += child->matches;
+      sum.cpu_utilization += child->cpu_utilization;
+      sum.rss_kb += child->rss_kb;
+      sum.descendants += 1 + child->descendants;
+    }
+  }
+}
+
+// depth first, only the children of the nodes listed get sorted
+void ProcessTree::Rows(vector<Process>& processes, size_t count, SortKey key,
+                       const std::unordered_set<int>& collapsed,
+                       vector<TreeRow>& rows) {
+  auto before = [&processes, key](const Node* a, const Node* b) {
+    switch (key) {
+      case SortKey::kCpu:
+        return a->cpu_utilization > b->cpu_utilization;
+      case SortKey::kRss:
+        return a->rss_kb > b->rss_kb;
+      default:
+        return processes[a->index].Before(processes[b->index], key);
+    }
+  };
+  auto push = [this, &before](vector<Node*>& nodes, int depth) {
+    std::sort(nodes.begin(), nodes.end(), before);
+    for (auto node = nodes.rbegin(); node != nodes.rend(); ++node) {
+      if ((*node)->matches > 0) {
+        stack_.emplace_back(*node, depth);
+      }
+    }
+  };
+  rows.clear();
+  stack_.clear();
+  push(roots_, 0);
+  while (!stack_.empty() && rows.size() < count) {
+    Node* node = stack_.back().first;
+    int depth = stack_.back().second;
+    stack_.pop_back();
+    bool folded = !node->children.empty() && collapsed.count(node->pid) > 0;
+    rows.push_back(TreeRow{node->index, depth, node->cpu_utilization,
+                           node->rss_kb, node->descendants, folded});
+    if (!folded) {
+      push(node->children, depth + 1);
+    }
+  }
+}
+
+bool ProcessTree::Contains(int pid) const {
+  return nodes_.count(pid) > 0;
+}
+
+void ProcessTree::Unlink(Node& node) {
+  if (node.parent != nullptr) {
+    vector<Node*>& siblings = node.parent->children;
+    auto self = std::find(siblings.begin(), siblings.end(), &node);
+    if (self != siblings.end()) {
+      *self = siblings.back();
+      siblings.pop_back();
+    }
+    node.parent = nullptr;
+  }
+}
@@ -1,9 +1,61 @@
 #include "processor.h"
-#include "../include/linux_parser.h"
+#include "linux_parser.h"
+
+using std::vector;
 
 // DONE: Return the aggregate CPU utilization
 float Processor::Utilization() {
-  float total_time = LinuxParser::Jiffies();
-  float active_time = LinuxParser::ActiveJiffies();
-  return 1.0 * (active_time/total_time);
-}
\ No newline at end of file
+  return shares_[0].utilization;
+}
+
+void Processor::Update(const SystemSnapshot& snapshot) {
+  const vector<uint64_t>& current = snapshot.cpu_jiffies;
+  // first snapshot or cpus were added, the first deltas are since boot
+  if (previous_.size() != current.size()) {
+    previous_.assign(current.size(), 0);
+  }
+  delta_.resize(current.size());
+
+  // counters may go back when a cpu is brought online again
+  const uint64_t* now = current.data();
+  const uint64_t* before = previous_.data();
+  uint64_t* delta = delta_.data();
+  for (size_t i = 0; i < current.size(); ++i) {
+    delta[i] = now[i] > before[i] ? now[i] - before[i] : 0;
+  }
+  previous_ = current;
+
+  using namespace LinuxParser;
+  size_t rows = current.size() / kCpuStates;
+  shares_.resize(rows);
+  for (size_t row = 0; row < rows; ++row) {
+    const uint64_t* d = delta + row * kCpuStates;
+    float total = Jiffies(d);
+    CpuShare& share = shares_[row];
+    if (total <= 0) {
+      share = CpuShare{};
+      continue;
+    }
+    share.utilization = ActiveJiffies(d) / total;
+    share.user = (d[kUser_] + d[kNice_]) / total;
+    share.system = (d[kSystem_] + d[kIRQ_] + d[kSoftIRQ_]) / total;
+    share.iowait = d[kIOwait_] / total;
+    share.steal = d[kSteal_] / total;
+  }
+}
+
+int Processor::Cores() const {
+  return shares_.size() - 1;
+}
+
+const CpuShare& Processor::Share() const {
+  return shares_[0];
+}
+
+const CpuShare& Processor::Share(int core) const {
+  return shares_[core + 1];
+}
+
+const vector<CpuShare>& Processor::Shares() const {
+  return shares_;
+}
@@ -0,0 +1,405 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstring>
+
+#include "linux_parser.h"
+#include "recording.h"
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace {
+const char kMagic[8] = {'C', 'P', 'P', 'M', 'O', 'N', 'R', 2};
+// bytes of the shortest process record: a pid delta, the delta flag,
+// three signed deltas and two string indexes
+const size_t kMinProcessBytes{7};
+
+void PutVarint(string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+// zigzag keeps small negative deltas small
+void PutSigned(string& out, int64_t value) {
+  PutVarint(out, (static_cast<uint64_t>(value) << 1) ^
+                     static_cast<uint64_t>(value >> 63));
+}
+
+void PutString(string& out, const string& value) {
+  PutVarint(out, value.size());
+  out += value;
+}
+
+void PutFloat(string& out, float value) {
+  char bytes[sizeof(float)];
+  std::memcpy(bytes, &value, sizeof(float));
+  out.append(bytes, sizeof(float));
+}
+
+// bounds checked reads, ok turns false on truncated data
+struct Cursor {
+  const unsigned char* position;
+  const unsigned char* end;
+  bool ok{true};
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (position == end) {
+        ok = false;
+        return 0;
+      }
+      unsigned char byte = *position++;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    ok = false;
+    return 0;
+  }
+  int64_t Signed() {
+    uint64_t value = Varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+  unsigned char Byte() {
+    if (position == end) {
+      ok = false;
+      return 0;
+    }
+    return *position++;
+  }
+  float Float() {
+    float value = 0;
+    if (end - position < static_cast<long>(sizeof(float))) {
+      ok = false;
+      return value;
+    }
+    std::memcpy(&value, position, sizeof(float));
+    position += sizeof(float);
+    return value;
+  }
+  string String() {
+    uint64_t length = Varint();
+    if (!ok || static_cast<uint64_t>(end - position) < length) {
+      ok = false;
+      return string();
+    }
+    string value(reinterpret_cast<const char*>(position), length);
+    position += length;
+    return value;
+  }
+  void Skip(uint64_t length) {
+    if (static_cast<uint64_t>(end - position) < length) {
+      ok = false;
+      position = end;
+      return;
+    }
+    position += length;
+  }
+};
+}  // namespace
+
+Recorder::~Recorder() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+  }
+}
+
+bool Recorder::Open(const string& path, const string& operating_system,
+                    const string& kernel) {
+  file_ = std::fopen(path.c_str(), "wb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  string header(kMagic, sizeof(kMagic));
+  PutVarint(header, kKeyframeInterval);
+  PutString(header, operating_system);
+  PutString(header, kernel);
+  return std::fwrite(header.data(), 1, header.size(), file_) == header.size();
+}
+
+uint64_t Recorder::Intern(const string& value, string& new_strings,
+                          uint64_t& new_count) {
+  auto found = strings_.find(value);
+  if (found != strings_.end()) {
+    return found->second;
+  }
+  uint64_t index = strings_.size();
+  strings_.emplace(value, index);
+  PutString(new_strings, value);
+  ++new_count;
+  return index;
+}
+
+/*
+Tick layout, after its varint payload size:
+  varint size of the new strings, varint count, (varint length, bytes)*
+  byte keyframe
+  signed time delta, signed clock delta in microseconds, signed uptime
+  delta, float memory utilization
+  varint total processes, varint running processes
+  varint counter count, signed counter deltas
+  varint process count, for every process ordered by PID:
+    varint PID delta, byte delta coded, signed start time, cpu jiffies
+    and rss, varint user string, varint command string
+*/
+bool Recorder::Write(const TickRecord& tick) {
+  if (file_ == nullptr) {
+    return false;
+  }
+  bool keyframe = ticks_ % kKeyframeInterval == 0;
+  if (keyframe) {
+    strings_.clear();
+    previous_.clear();
+    previous_counters_.clear();
+    previous_time_ = 0;
+    previous_clock_ = 0;
+    previous_uptime_ = 0;
+  }
+
+  string new_strings;
+  uint64_t new_count = 0;
+  string body;
+  body += static_cast<char>(keyframe);
+  int64_t clock = std::llround(tick.system.clock_seconds * 1e6);
+  PutSigned(body, tick.time_ms - previous_time_);
+  PutSigned(body, clock - previous_clock_);
+  PutSigned(body, tick.system.uptime - previous_uptime_);
+  PutFloat(body, tick.system.memory_utilization);
+  PutVarint(body, tick.system.total_processes);
+  PutVarint(body, tick.system.running_processes);
+
+  const vector<uint64_t>& counters = tick.system.cpu_jiffies;
+  if (previous_counters_.size() != counters.size()) {
+    previous_counters_.assign(counters.size(), 0);
+  }
+  PutVarint(body, counters.size());
+  for (size_t i = 0; i < counters.size(); ++i) {
+    PutSigned(body, counters[i] - previous_counters_[i]);
+  }
+  previous_counters_ = counters;
+
+  PutVarint(body, tick.processes.size());
+  int previous_pid = 0;
+  std::unordered_map<int, Previous> current;
+  current.reserve(tick.processes.size());
+  for (const ProcessRecord& process : tick.processes) {
+    PutVarint(body, process.pid - previous_pid);
+    previous_pid = process.pid;
+    Previous base{0, 0, 0};
+    auto found = previous_.find(process.pid);
+    bool delta = found != previous_.end() &&
+                 found->second.start_time == process.start_time;
+    if (delta) {
+      base = found->second;
+    }
+    body += static_cast<char>(delta);
+    PutSigned(body, process.start_time - base.start_time);
+    PutSigned(body, process.cpu_jiffies - base.cpu_jiffies);
+    PutSigned(body, process.rss_kb - base.rss_kb);
+    PutVarint(body, Intern(process.user, new_strings, new_count));
+    PutVarint(body, Intern(process.command, new_strings, new_count));
+    current[process.pid] =
+        Previous{process.start_time, process.cpu_jiffies, process.rss_kb};
+  }
+  previous_.swap(current);
+  previous_time_ = tick.time_ms;
+  previous_clock_ = clock;
+  previous_uptime_ = tick.system.uptime;
+
+  string strings;
+  PutVarint(strings, new_count);
+  strings += new_strings;
+  string payload;
+  PutVarint(payload, strings.size());
+  payload += strings;
+  payload += body;
+
+  buffer_.clear();
+  PutVarint(buffer_, payload.size());
+  buffer_ += payload;
+  ++ticks_;
+  return std::fwrite(buffer_.data(), 1, buffer_.size(), file_) ==
+             buffer_.size() &&
+         std::fflush(file_) == 0;
+}
+
+Recording::~Recording() {
+  if (data_ != nullptr) {
+    munmap(const_cast<unsigned char*>(data_), size_);
+  }
+}
+
+bool Recording::Open(const string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < long(sizeof(kMagic))) {
+    close(fd);
+    return false;
+  }
+  size_ = info.st_size;
+  void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    size_ = 0;
+    return false;
+  }
+  data_ = static_cast<const unsigned char*>(mapped);
+  if (std::memcmp(data_, kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+
+  Cursor cursor{data_ + sizeof(kMagic), data_ + size_};
+  keyframe_interval_ = cursor.Varint();
+  operating_system_ = cursor.String();
+  kernel_ = cursor.String();
+  if (!cursor.ok || keyframe_interval_ <= 0) {
+    return false;
+  }
+  // only the tick sizes are walked, a tick cut short by a crash ends
+  // the recording
+  while (cursor.position < cursor.end) {
+    uint64_t payload_size = cursor.Varint();
+    if (!cursor.ok ||
+        static_cast<uint64_t>(cursor.end - cursor.position) < payload_size) {
+      break;
+    }
+    offsets_.push_back(cursor.position - data_);
+    cursor.position += payload_size;
+    ends_.push_back(cursor.position - data_);
+  }
+  return true;
+}
+
+size_t Recording::Ticks() const {
+  return offsets_.size();
+}
+
+const string& Recording::OperatingSystem() const {
+  return operating_system_;
+}
+
+const string& Recording::Kernel() const {
+  return kernel_;
+}
+
+bool Recording::Read(size_t index, TickRecord& tick) {
+  if (index >= offsets_.size()) {
+    return false;
+  }
+  if (index != next_) {
+    next_ = index - index % keyframe_interval_;
+  }
+  while (next_ <= index) {
+    if (!Decode(next_, tick)) {
+      next_ = offsets_.size();
+      return false;
+    }
+    ++next_;
+  }
+  return true;
+}
+
+bool Recording::Decode(size_t index, TickRecord& tick) {
+  const unsigned char* payload = data_ + offsets_[index];
+  // a corrupt count can't claim more than the bytes left in the tick
+  Cursor cursor{payload, data_ + ends_[index]};
+  uint64_t strings_size = cursor.Varint();
+  const unsigned char* strings_start = cursor.position;
+  cursor.Skip(strings_size);
+  Cursor strings{strings_start, cursor.position};
+  bool keyframe = cursor.Byte() != 0;
+  if (keyframe) {
+    strings_.clear();
+    previous_.clear();
+    previous_counters_.clear();
+    previous_time_ = 0;
+    previous_clock_ = 0;
+    previous_uptime_ = 0;
+  }
+  uint64_t new_strings = strings.Varint();
+  for (uint64_t i = 0; strings.ok && i < new_strings; ++i) {
+    strings_.push_back(strings.String());
+  }
+  if (!cursor.ok || !strings.ok) {
+    return false;
+  }
+  tick.time_ms = previous_time_ + cursor.Signed();
+  int64_t clock = previous_clock_ + cursor.Signed();
+  tick.system.clock_seconds = clock / 1e6;
+  tick.system.uptime = previous_uptime_ + cursor.Signed();
+  tick.system.memory_utilization = cursor.Float();
+  tick.system.total_processes = cursor.Varint();
+  tick.system.running_processes = cursor.Varint();
+
+  size_t counters = cursor.Varint();
+  if (!cursor.ok ||
+      counters > static_cast<size_t>(cursor.end - cursor.position)) {
+    return false;
+  }
+  if (previous_counters_.size() != counters) {
+    previous_counters_.assign(counters, 0);
+  }
+  vector<uint64_t>& jiffies = tick.system.cpu_jiffies;
+  jiffies.resize(counters);
+  for (size_t i = 0; i < counters; ++i) {
+    jiffies[i] = previous_counters_[i] + cursor.Signed();
+  }
+  previous_counters_ = jiffies;
+  if (counters >= size_t(LinuxParser::kCpuStates)) {
+    tick.system.cpu_count = counters / LinuxParser::kCpuStates - 1;
+    tick.system.total_jiffies = LinuxParser::Jiffies(jiffies.data());
+    tick.system.idle_jiffies = LinuxParser::IdleJiffies(jiffies.data());
+    tick.system.active_jiffies =
+        tick.system.total_jiffies - tick.system.idle_jiffies;
+  }
+
+  size_t count = cursor.Varint();
+  if (!cursor.ok ||
+      count > (cursor.end - cursor.position) / kMinProcessBytes) {
+    return false;
+  }
+  tick.processes.resize(count);
+  std::unordered_map<int, Previous> current;
+  current.reserve(count);
+  int pid = 0;
+  for (ProcessRecord& process : tick.processes) {
+    pid += cursor.Varint();
+    process.pid = pid;
+    Previous base{0, 0, 0};
+    if (cursor.Byte() != 0) {
+      auto found = previous_.find(pid);
+      if (found != previous_.end()) {
+        base = found->second;
+      }
+    }
+    process.start_time = base.start_time + cursor.Signed();
+    process.cpu_jiffies = base.cpu_jiffies + cursor.Signed();
+    process.rss_kb = base.rss_kb + cursor.Signed();
+    uint64_t user = cursor.Varint();
+    uint64_t command = cursor.Varint();
+    if (!cursor.ok || user >= strings_.size() || command >= strings_.size()) {
+      return false;
+    }
+    process.user = strings_[user];
+    process.command = strings_[command];
+    current[pid] =
+        Previous{process.start_time, process.cpu_jiffies, process.rss_kb};
+  }
+  previous_.swap(current);
+  previous_time_ = tick.time_ms;
+  previous_clock_ = clock;
+  previous_uptime_ = tick.system.uptime;
+  return cursor.ok;
+}
@@ -0,0 +1,234 @@
+#include <algorithm>
+
+#include "sampler.h"
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+// points of the sparklines
+const size_t kSystemHistoryPoints{40};
+const size_t kProcessHistoryPoints{10};
+// thread rows a sample keeps per process, the busiest ones
+const size_t kThreadRows{16};
+}  // namespace
+
+constexpr milliseconds Sampler::kMinInterval;
+
+Sampler::Sampler(System& system, milliseconds interval, size_t top_count)
+    : system_(system), interval_(std::max(interval, kMinInterval)) {
+  system_.TopCount(top_count);
+}
+
+Sampler::~Sampler() {
+  Stop();
+}
+
+void Sampler::Start() {
+  if (thread_.joinable()) {
+    return;
+  }
+  running_ = true;
+  thread_ = std::thread(&Sampler::Run, this);
+}
+
+void Sampler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  wake_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool Sampler::Update() {
+  return samples_.Update();
+}
+
+const Sample& Sampler::Latest() const {
+  return samples_.Front();
+}
+
+void Sampler::SortBy(SortKey key) {
+  sort_key_ = key;
+  Wake();
+}
+
+void Sampler::Seek(long ticks) {
+  seek_ += ticks;
+  Wake();
+}
+
+void Sampler::Pause() {
+  paused_ = !paused_;
+  Wake();
+}
+
+void Sampler::Expand(int pid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    expand_.push_back(pid);
+  }
+  Wake();
+}
+
+void Sampler::ExpandTop(size_t count) {
+  expand_top_ = count;
+  Wake();
+}
+
+void Sampler::GroupByCgroup() {
+  grouped_ = !grouped_;
+  Wake();
+}
+
+void Sampler::TreeView() {
+  tree_ = !tree_;
+  Wake();
+}
+
+void Sampler::Collapse(int pid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collapse_.push_back(pid);
+  }
+  Wake();
+}
+
+void Sampler::FilterBy(const ProcessFilter& filter) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    filter_ = filter;
+    filtered_ = true;
+  }
+  Wake();
+}
+
+void Sampler::Wake() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    woken_ = true;
+  }
+  wake_.notify_one();
+}
+
+void Sampler::Run() {
+  auto deadline = steady_clock::now();
+  while (true) {
+    system_.SortBy(sort_key_);
+    system_.ExpandTop(expand_top_);
+    system_.GroupByCgroup(grouped_);
+    system_.TreeView(tree_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (int pid : expand_) {
+        system_.Expand(pid, !system_.Expanded(pid));
+      }
+      expand_.clear();
+      for (int pid : collapse_) {
+        system_.Collapse(pid, !system_.Collapsed(pid));
+      }
+      collapse_.clear();
+      if (filtered_) {
+        system_.FilterBy(filter_);
+        filtered_ = false;
+      }
+    }
+    if (system_.ReplayTicks() > 0) {
+      long seek = seek_.exchange(0);
+      if (seek != 0) {
+        system_.Seek(seek);
+      }
+      system_.Pause(paused_);
+    }
+    Fill(samples_.Back());
+    samples_.Publish();
+
+    // fixed rate: ticks are due at multiples of the interval from the
+    // start, ticks which are already late are skipped and an early tick
+    // asked by SortBy() or Seek() does not move the schedule
+    auto now = steady_clock::now();
+    while (deadline <= now) {
+      deadline += interval_;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait_until(lock, deadline, [this] { return !running_ || woken_; });
+    if (!running_) {
+      return;
+    }
+    woken_ = false;
+  }
+}
+
+// the buffers are reused from tick to tick
+void Sampler::Fill(Sample& sample) {
+  std::vector<Process>& processes = system_.Processes();
+  sample.operating_system = system_.OperatingSystem();
+  sample.kernel = system_.Kernel();
+  sample.system = system_.Snapshot();
+  sample.cpu_shares = system_.Cpu().Shares();
+  sample.disks = system_.DiskRates();
+  sample.network = system_.Traffic();
+  const History& history = system_.Trends();
+  history.Cpu().Latest(kSystemHistoryPoints, sample.cpu_history);
+  history.Memory().Latest(kSystemHistoryPoints, sample.memory_history);
+  sample.cpu_stats = system_.CpuStats(kStatsWindow);
+  sample.memory_stats = system_.MemoryStats(kStatsWindow);
+  sample.sort_key = system_.SortedBy();
+  sample.replay_tick = system_.ReplayTick();
+  sample.replay_ticks = system_.ReplayTicks();
+  sample.replay_time_ms = system_.ReplayTime();
+  sample.paused = system_.Paused();
+  sample.grouped = system_.GroupedByCgroup();
+  if (sample.grouped) {
+    sample.cgroups = system_.ControlGroups();
+  } else {
+    sample.cgroups.clear();
+  }
+  sample.tree = system_.TreeViewed();
+  sample.filter = system_.Filtering().Text();
+  sample.alerts = system_.FiringAlerts();
+  const std::vector<TreeRow>& tree = system_.TreeRows();
+  for (int stage = 0; stage < SelfStats::kStages; ++stage) {
+    sample.self_stats[stage] =
+        SelfStats::Summarize(static_cast<SelfStats::Stage>(stage));
+  }
+  sample.processes.resize(processes.size());
+  for (size_t i = 0; i < processes.size(); ++i) {
+    ProcessSample& row = sample.processes[i];
+    row.pid = processes[i].Pid();
+    row.user = processes[i].User();
+    row.command = processes[i].Command();
+    row.cpu_utilization = processes[i].CpuUtilization();
+    row.ram_kb = processes[i].RamKb();
+    row.pss_kb = processes[i].PssKb();
+    row.uss_kb = processes[i].UssKb();
+    row.read_rate = processes[i].ReadRate();
+    row.write_rate = processes[i].WriteRate();
+    row.uptime = processes[i].UpTime();
+    const Series* cpu_history = history.ProcessCpu(row.pid);
+    if (cpu_history != nullptr) {
+      cpu_history->Latest(kProcessHistoryPoints, row.cpu_history);
+    } else {
+      row.cpu_history.clear();
+    }
+    row.expanded = system_.Expanded(row.pid);
+    const std::vector<Task>* tasks = system_.Tasks(row.pid);
+    row.thread_count = tasks != nullptr ? tasks->size() : 0;
+    row.threads.clear();
+    for (size_t t = 0; t < std::min(kThreadRows, row.thread_count); ++t) {
+      row.threads.push_back((*tasks)[t]);
+    }
+    TreeRow node = i < tree.size() ? tree[i] : TreeRow{};
+    row.depth = node.depth;
+    row.subtree_cpu = node.cpu_utilization;
+    row.subtree_rss_kb = node.rss_kb;
+    row.descendants = node.descendants;
+    row.collapsed = node.collapsed;
+    row.alerting = std::any_of(
+        sample.alerts.begin(), sample.alerts.end(),
+        [&row](const Alert& alert) { return alert.pid == row.pid; });
+  }
+}
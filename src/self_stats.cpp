@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "ring_buffer.h"
+#include "self_stats.h"
+
+using std::size_t;
+using std::vector;
+
+namespace {
+std::atomic<uint64_t> syscalls{0};
+std::atomic<uint64_t> bytes_read{0};
+std::atomic<uint64_t> allocations{0};
+// constant initialized, so operator new can count into it on any thread
+thread_local SelfStats::Counters thread_counters;
+
+struct Tick {
+  double milliseconds;
+  SelfStats::Counters counters;
+};
+
+struct Ticks {
+  std::mutex mutex;
+  vector<RingBuffer<Tick>> stages =
+      vector<RingBuffer<Tick>>(SelfStats::kStages,
+                               RingBuffer<Tick>(SelfStats::kTicks));
+  vector<double> scratch;
+  // every tick since the start, not only the ones kept
+  vector<uint64_t> counts = vector<uint64_t>(SelfStats::kStages);
+  vector<double> totals = vector<double>(SelfStats::kStages);
+};
+
+Ticks& History() {
+  static Ticks ticks;
+  return ticks;
+}
+
+void Add(SelfStats::Stage stage, const Tick& tick) {
+  Ticks& ticks = History();
+  std::lock_guard<std::mutex> lock(ticks.mutex);
+  ticks.stages[stage].Push(tick);
+  ++ticks.counts[stage];
+  ticks.totals[stage] += tick.milliseconds;
+}
+}  // namespace
+
+// counting needs the allocation itself and a relaxed add, the pointers
+// still come from malloc() so the default operator delete frees them
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  ++thread_counters.allocations;
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+const char* const SelfStats::kStageNames[kStages] = {"discovery", "parse",
+                                                     "sort", "render"};
+
+SelfStats::Counters SelfStats::Totals() {
+  Counters counters;
+  counters.syscalls = syscalls.load(std::memory_order_relaxed);
+  counters.bytes_read = bytes_read.load(std::memory_order_relaxed);
+  counters.allocations = allocations.load(std::memory_order_relaxed);
+  return counters;
+}
+
+SelfStats::Counters SelfStats::ThreadTotals() {
+  return thread_counters;
+}
+
+void SelfStats::Credit(const Counters& counters) {
+  thread_counters.syscalls += counters.syscalls;
+  thread_counters.bytes_read += counters.bytes_read;
+  thread_counters.allocations += counters.allocations;
+}
+
+void SelfStats::CountRead(uint64_t calls, uint64_t bytes) {
+  syscalls.fetch_add(calls, std::memory_order_relaxed);
+  bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+  thread_counters.syscalls += calls;
+  thread_counters.bytes_read += bytes;
+}
+
+SelfStats::Summary SelfStats::Summarize(Stage stage) {
+  Ticks& ticks = History();
+  std::lock_guard<std::mutex> lock(ticks.mutex);
+  const RingBuffer<Tick>& buffer = ticks.stages[stage];
+  Summary summary;
+  summary.ticks = buffer.Size();
+  summary.count = ticks.counts[stage];
+  summary.total_milliseconds = ticks.totals[stage];
+  if (buffer.Size() == 0) {
+    return summary;
+  }
+  vector<double>& times = ticks.scratch;
+  times.clear();
+  for (size_t i = 0; i < buffer.Size(); ++i) {
+    times.push_back(buffer[i].milliseconds);
+    summary.syscalls += buffer[i].counters.syscalls;
+    summary.bytes_read += buffer[i].counters.bytes_read;
+    summary.allocations += buffer[i].counters.allocations;
+  }
+  summary.syscalls /= buffer.Size();
+  summary.bytes_read /= buffer.Size();
+  summary.allocations /= buffer.Size();
+  std::sort(times.begin(), times.end());
+  auto percentile = [&times](double share) {
+    return times[static_cast<size_t>(share * (times.size() - 1) + 0.5)];
+  };
+  summary.p50 = percentile(0.50);
+  summary.p95 = percentile(0.95);
+  summary.p99 = percentile(0.99);
+  summary.max = times.back();
+  return summary;
+}
+
+SelfStats::Timer::Timer(Stage stage)
+    : stage_(stage),
+      start_(std::chrono::steady_clock::now()),
+      counters_(ThreadTotals()) {}
+
+SelfStats::Timer::~Timer() {
+  Counters end = ThreadTotals();
+  Tick tick;
+  tick.milliseconds = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start_)
+                          .count();
+  tick.counters.syscalls = end.syscalls - counters_.syscalls;
+  tick.counters.bytes_read = end.bytes_read - counters_.bytes_read;
+  tick.counters.allocations = end.allocations - counters_.allocations;
+  Add(stage_, tick);
+}
@@ -0,0 +1,44 @@
+#include "string_pool.h"
+
+using std::string;
+
+const StringPool::Handle& StringPool::Empty() {
+  static const Handle empty = std::make_shared<const string>();
+  return empty;
+}
+
+StringPool::Handle StringPool::Intern(std::string_view text) {
+  if (text.empty()) {
+    return Empty();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = strings_.find(text);
+  if (entry != strings_.end()) {
+    Handle handle = entry->second.handle.lock();
+    if (handle != nullptr) {
+      return handle;
+    }
+    // its last handle is being dropped, Release() leaves the new copy
+    strings_.erase(entry);
+  }
+  const string* copy = new string(text);
+  Handle handle(copy, [this](const string* string) { Release(string); });
+  strings_.emplace(std::string_view(*copy), Entry{copy, handle});
+  return handle;
+}
+
+std::size_t StringPool::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.size();
+}
+
+void StringPool::Release(const string* string) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = strings_.find(*string);
+    if (entry != strings_.end() && entry->second.string == string) {
+      strings_.erase(entry);
+    }
+  }
+  delete string;
+}
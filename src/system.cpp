@@ -1,6 +1,7 @@
 #include <unistd.h>
+#include <algorithm>
 #include <cstddef>
-#include <set>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -8,16 +9,31 @@
 #include "processor.h"
 #include "system.h"
 #include "linux_parser.h"
+#include "self_stats.h"
 
-using std::set;
 using std::size_t;
 using std::string;
 using std::vector;
 
+namespace {
+// processes refreshed by a worker between two claims of the counter
+const size_t kRefreshChunk{32};
+// sampling threads unless configured, /proc reads scale well to a few
+const unsigned int kDefaultThreads{4};
+// smaps_rollup walks every mapping of a process, it is only read for the
+// first rows shown and at most once per period for each of them
+const size_t kSmapsRows{25};
+const long kSmapsPeriodMs{5000};
+}  // namespace
+
 
 System::System() {
   this->kernel_ = LinuxParser::Kernel();
   this->os_ = LinuxParser::OperatingSystem();
+  this->pool_ = std::make_unique<WorkerPool>(
+      std::max(1u, std::min(kDefaultThreads, std::thread::hardware_concurrency())));
+  this->snapshot_ = SystemSnapshot::Capture();
+  this->cpu_.Update(snapshot_);
 }
 
 // DONE: Return the system's CPU
@@ -25,36 +41,413 @@ Processor& System::Cpu() {
   return cpu_;
 }
 
+const vector<DiskRate>& System::DiskRates() const {
+  return disks_.Rates();
+}
+
+const NetworkRates& System::Traffic() const {
+  return network_.Rates();
+}
+
 // DONE: Return a container composed of the system's processes
 vector<Process>& System::Processes() {
-  vector<int> pids = LinuxParser::Pids();
+  bool sampled = true;
+  if (recording_ == nullptr) {
+    Sample();
+  } else {
+    sampled = (!paused_ || seeked_) && Advance();
+    seeked_ = false;
+    // the filter may have changed while paused
+    Match();
+  }
+
+  if (sampled && !alerts_.Empty()) {
+    // the rules see every process, filtered or not
+    bool live = recording_ == nullptr;
+    int64_t now_ms =
+        live ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count()
+             : tick_.time_ms;
+    alerts_.Update(processes_.Processes(), cpu_.Share(), snapshot_,
+                   tick_count_, live, now_ms, *pool_);
+  }
+
+  // only the rows which are shown get ordered, and only they get the
+  // fields which are displayed but not sorted by
+  {
+    SelfStats::Timer timer(SelfStats::kSort);
+    SortKey key = sort_key_;
+    if (recording_ == nullptr) {
+      size_t smaps = kSmapsRows;
+      long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - start_)
+                        .count();
+      auto prepare = [this, &smaps, now_ms](Process& process) {
+        process.Fetch(kDisplayFields, snapshot_, tick_count_);
+        if (smaps > 0) {
+          --smaps;
+          process.Smaps(now_ms, kSmapsPeriodMs);
+        }
+      };
+      tree_rows_.clear();
+      if (tree_view_) {
+        vector<Process>& processes = processes_.Processes();
+        tree_.Rows(processes, top_count_, key, collapsed_, tree_rows_);
+        top_.clear();
+        for (const TreeRow& row : tree_rows_) {
+          prepare(processes[row.index]);
+          top_.push_back(processes[row.index]);
+        }
+      } else {
+        processes_.Top(top_count_, key, prepare, top_);
+      }
+      ScanTasks();
+    } else {
+      tree_rows_.clear();
+      processes_.Top(top_count_, key, [](Process&) {}, top_);
+    }
+  }
+
+  if (sampled) {
+    long second = recording_ != nullptr
+                      ? tick_.time_ms / 1000
+                      : std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now() - start_)
+                            .count();
+    history_.Add(second, cpu_, snapshot_, top_);
+  }
+  return top_;
+}
 
-  // remove processes which are closed
-  processes_.erase(std::remove_if(processes_.begin(), processes_.end(), [&pids](const Process& p){
-    return std::find(pids.begin(), pids.end(), p.Pid()) == pids.end();
-  }), processes_.end());
+void System::Sample() {
+  {
+    // births and deaths are found through the PID keyed table
+    SelfStats::Timer timer(SelfStats::kDiscovery);
+    discovery_.Pids(pids_, execs_);
+    processes_.Update(pids_);
+    for (int pid : execs_) {
+      Process* process = processes_.Lookup(pid);
+      if (process != nullptr) {
+        process->Exec();
+      }
+    }
+  }
+
+  SelfStats::Timer timer(SelfStats::kParse);
+  // system wide counters are read once and shared by every process
+  snapshot_ = SystemSnapshot::Capture();
+  cpu_.Update(snapshot_);
+  disks_.Update(snapshot_);
+  network_.Update(snapshot_);
+
+  // every process only gets the fields its order needs, the per
+  // process reads are spread over the pool
+  ++tick_count_;
+  Match();
+  Fetch(Process::Fields(sort_key_));
+  if (grouped_) {
+    // the cgroup of a process is only read when its PID is new
+    Fetch(kStatField | kCgroupField);
+    cgroups_.Update(processes_.Processes(), snapshot_);
+  }
+  if (tree_view_) {
+    // the parent PID comes with the stat file
+    Fetch(kStatField, true);
+    tree_.Update(processes_.Processes());
+    for (auto pid = collapsed_.begin(); pid != collapsed_.end();) {
+      pid = tree_.Contains(*pid) ? std::next(pid) : collapsed_.erase(pid);
+    }
+  }
+}
 
-  set<int> existing_pids;
-  for (const Process &process: processes_) {
-    existing_pids.insert(process.Pid());
+void System::Fetch(unsigned int fields, bool unmatched) {
+  if (fields == 0) {
+    return;
   }
+  vector<Process>& processes = processes_.Processes();
+  pool_->ParallelFor(
+      processes.size(), kRefreshChunk,
+      [this, fields, unmatched, &processes](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (unmatched || processes[i].Matched()) {
+            processes[i].Fetch(fields, snapshot_, tick_count_);
+          }
+        }
+      });
+}
 
-  // put new processes
-  for (int pid: pids) {
-    if (existing_pids.find(pid) == existing_pids.end()) {
-      processes_.emplace_back(pid);
+// the predicates fetch the fields they test, cheapest first, so the
+// other files of a process rejected early are not opened during the
+// tick. A replay tests the recorded values
+void System::Match() {
+  vector<Process>& processes = processes_.Processes();
+  if (filter_.Empty()) {
+    for (Process& process : processes) {
+      process.Match(true);
+    }
+    return;
+  }
+  bool live = recording_ == nullptr;
+  pool_->ParallelFor(
+      processes.size(), kRefreshChunk,
+      [this, live, &processes](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          Process& process = processes[i];
+          process.Match(
+              filter_.Matches(process, [&](unsigned int fields) {
+                if (live) {
+                  process.Fetch(fields, snapshot_, tick_count_);
+                }
+              }));
+        }
+      });
+}
+
+// one stat read per thread, so only the shown rows which are expanded
+// get their threads read
+void System::ScanTasks() {
+  for (auto pid = expanded_.begin(); pid != expanded_.end();) {
+    pid = processes_.Lookup(*pid) == nullptr ? expanded_.erase(pid)
+                                             : std::next(pid);
+  }
+  for (size_t i = 0; i < top_.size(); ++i) {
+    int pid = top_[i].Pid();
+    if (i >= expand_top_ && expanded_.count(pid) == 0) {
+      continue;
     }
+    TaskList& tasks = tasks_.try_emplace(pid, pid).first->second;
+    tasks.Refresh(snapshot_);
+    tasks.tick = tick_count_;
+  }
+  // lists of rows which are collapsed or gone start over when shown again
+  for (auto tasks = tasks_.begin(); tasks != tasks_.end();) {
+    tasks = tasks->second.tick != tick_count_ ? tasks_.erase(tasks)
+                                              : std::next(tasks);
+  }
+}
+
+// load the next recorded tick, false at the end of the recording
+bool System::Advance() {
+  long ticks = recording_->Ticks();
+  if (replay_next_ >= ticks) {
+    return false;
+  }
+  if (!recording_->Read(replay_next_, tick_)) {
+    replay_next_ = ticks;
+    return false;
+  }
+  ++replay_next_;
+  snapshot_ = tick_.system;
+  cpu_.Update(snapshot_);
+  disks_.Update(snapshot_);
+  network_.Update(snapshot_);
+  pids_.clear();
+  for (const ProcessRecord& record : tick_.processes) {
+    pids_.push_back(record.pid);
+  }
+  processes_.Update(pids_);
+  for (const ProcessRecord& record : tick_.processes) {
+    processes_.Lookup(record.pid)->refresh(snapshot_, record);
+  }
+  return true;
+}
+
+void System::Record(TickRecord& tick) {
+  tick.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+  tick.system = snapshot_;
+  Fetch(kStatField | kUserField | kCommandField, true);
+  vector<Process>& processes = processes_.Processes();
+  tick.processes.resize(processes.size());
+  for (size_t i = 0; i < processes.size(); ++i) {
+    ProcessRecord& record = tick.processes[i];
+    record.pid = processes[i].Pid();
+    record.start_time = processes[i].StartTime();
+    record.cpu_jiffies = processes[i].CpuJiffies();
+    record.rss_kb = processes[i].RssKb();
+    record.user = processes[i].User();
+    record.command = processes[i].Command();
+  }
+  std::sort(tick.processes.begin(), tick.processes.end(),
+            [](const ProcessRecord& a, const ProcessRecord& b) {
+              return a.pid < b.pid;
+            });
+}
+
+bool System::Replay(const string& path) {
+  auto recording = std::make_unique<Recording>();
+  if (!recording->Open(path)) {
+    return false;
+  }
+  recording_ = std::move(recording);
+  os_ = recording_->OperatingSystem();
+  kernel_ = recording_->Kernel();
+  Seek(std::numeric_limits<long>::min());
+  return true;
+}
+
+// the deltas restart at the target, which is loaded after the tick
+// before it so its CPU usage is known right away
+void System::Seek(long ticks) {
+  long count = recording_->Ticks();
+  long shown = replay_next_ - 1;
+  long target = ticks < 0 ? std::max(0L, shown + std::max(ticks, -shown))
+                          : std::min(count - 1, shown + std::min(ticks, count));
+  cpu_ = Processor();
+  disks_ = Disks();
+  network_ = Network();
+  processes_.Clear();
+  history_ = History();
+  replay_next_ = std::max(0L, target - 1);
+  if (target > 0) {
+    Advance();
+  }
+  seeked_ = true;
+}
+
+void System::Pause(bool paused) {
+  paused_ = paused;
+}
+
+bool System::Paused() const {
+  return paused_;
+}
+
+long System::ReplayTick() const {
+  return recording_ == nullptr ? -1 : replay_next_ - 1;
+}
+
+long System::ReplayTicks() const {
+  return recording_ == nullptr ? 0 : recording_->Ticks();
+}
+
+int64_t System::ReplayTime() const {
+  return tick_.time_ms;
+}
+
+void System::FilterBy(const ProcessFilter& filter) {
+  filter_ = filter;
+}
+
+const ProcessFilter& System::Filtering() const {
+  return filter_;
+}
+
+void System::SortBy(SortKey key) {
+  sort_key_ = key;
+}
+
+SortKey System::SortedBy() const {
+  return sort_key_;
+}
+
+void System::TopCount(size_t count) {
+  top_count_ = count;
+}
+
+const History& System::Trends() const {
+  return history_;
+}
+
+SeriesStats System::CpuStats(long seconds) const {
+  return history_.Cpu().Query(seconds);
+}
+
+SeriesStats System::CoreStats(int core, long seconds) const {
+  return history_.Core(core).Query(seconds);
+}
+
+SeriesStats System::MemoryStats(long seconds) const {
+  return history_.Memory().Query(seconds);
+}
+
+SeriesStats System::ProcessCpuStats(int pid, long seconds) const {
+  const Series* series = history_.ProcessCpu(pid);
+  return series == nullptr ? SeriesStats{} : series->Query(seconds);
+}
+
+SeriesStats System::ProcessRssStats(int pid, long seconds) const {
+  const Series* series = history_.ProcessRss(pid);
+  return series == nullptr ? SeriesStats{} : series->Query(seconds);
+}
+
+void System::Expand(int pid, bool expanded) {
+  if (expanded) {
+    expanded_.insert(pid);
+  } else {
+    expanded_.erase(pid);
   }
+}
 
-  // refresh CPU usage
-  for (Process &process: processes_) {
-    process.refresh();
+bool System::Expanded(int pid) const {
+  return expanded_.count(pid) > 0;
+}
+
+void System::ExpandTop(size_t count) {
+  expand_top_ = count;
+}
+
+const vector<Task>* System::Tasks(int pid) const {
+  auto tasks = tasks_.find(pid);
+  return tasks == tasks_.end() ? nullptr : &tasks->second.Tasks();
+}
+
+void System::GroupByCgroup(bool grouped) {
+  grouped_ = grouped;
+}
+
+bool System::GroupedByCgroup() const {
+  return grouped_ && recording_ == nullptr;
+}
+
+const vector<CgroupStats>& System::ControlGroups() const {
+  return cgroups_.Groups();
+}
+
+void System::TreeView(bool tree) {
+  tree_view_ = tree;
+}
+
+bool System::TreeViewed() const {
+  return tree_view_ && recording_ == nullptr;
+}
+
+void System::Collapse(int pid, bool collapsed) {
+  if (collapsed) {
+    collapsed_.insert(pid);
+  } else {
+    collapsed_.erase(pid);
   }
+}
 
-  // sort the processes by their cpu utilization
-  std::sort(processes_.begin(), processes_.end());
+bool System::Collapsed(int pid) const {
+  return collapsed_.count(pid) > 0;
+}
+
+const vector<TreeRow>& System::TreeRows() const {
+  return tree_rows_;
+}
+
+bool System::AddAlert(const std::string& rule, std::string& error) {
+  return alerts_.Add(rule, error);
+}
+
+const vector<Alert>& System::FiringAlerts() const {
+  return alerts_.Firing();
+}
 
-  return processes_;
+const vector<AlertEvent>& System::AlertEvents() const {
+  return alerts_.Events();
+}
+
+bool System::WatchEvents() {
+  return discovery_.Listen();
+}
+
+void System::Threads(unsigned int threads) {
+  pool_ = std::make_unique<WorkerPool>(std::max(1u, threads));
 }
 
 // DONE: Return the system's kernel identifier (string)
@@ -64,7 +457,7 @@ std::string System::Kernel() {
 
 // DONE: Return the system's memory utilization
 float System::MemoryUtilization() {
-  return LinuxParser::MemoryUtilization();
+  return snapshot_.memory_utilization;
 }
 
 // DONE: Return the operating system name
@@ -74,15 +467,20 @@ std::string System::OperatingSystem() {
 
 // DONE: Return the number of processes actively running on the system
 int System::RunningProcesses() {
-  return LinuxParser::RunningProcesses();
+  return snapshot_.running_processes;
 }
 
 // DONE: Return the total number of processes on the system
 int System::TotalProcesses() {
-  return LinuxParser::TotalProcesses();
+  return snapshot_.total_processes;
 }
 
 // DONE: Return the number of seconds since the system started running
 long int System::UpTime() {
-  return LinuxParser::UpTime();
+  return snapshot_.uptime;
+}
+
+// Return the values captured at the last refresh tick
+const SystemSnapshot& System::Snapshot() const {
+  return snapshot_;
 }
@@ -0,0 +1,37 @@
+#include <time.h>
+
+#include "system_snapshot.h"
+#include "linux_parser.h"
+
+SystemSnapshot SystemSnapshot::Capture() {
+  SystemSnapshot snapshot;
+  timespec now;
+  if (clock_gettime(CLOCK_BOOTTIME, &now) == 0) {
+    snapshot.clock_seconds = now.tv_sec + now.tv_nsec / 1e9;
+  }
+  LinuxParser::ProcessCounts processes;
+  LinuxParser::CpuJiffies(snapshot.cpu_jiffies, processes);
+  snapshot.cpu_count =
+      snapshot.cpu_jiffies.size() / LinuxParser::kCpuStates - 1;
+  snapshot.total_jiffies = LinuxParser::Jiffies(snapshot.cpu_jiffies.data());
+  snapshot.idle_jiffies = LinuxParser::IdleJiffies(snapshot.cpu_jiffies.data());
+  snapshot.active_jiffies = snapshot.total_jiffies - snapshot.idle_jiffies;
+  LinuxParser::Memory memory = LinuxParser::MemoryInfo();
+  snapshot.memory_utilization = LinuxParser::MemoryUtilization(memory);
+  snapshot.memory_total_kb = memory.total_kb;
+  snapshot.memory_available_kb = memory.available_kb;
+  snapshot.buffers_kb = memory.buffers_kb;
+  snapshot.cached_kb = memory.cached_kb;
+  snapshot.swap_total_kb = memory.swap_total_kb;
+  snapshot.swap_free_kb = memory.swap_free_kb;
+  snapshot.uptime = LinuxParser::UpTime();
+  snapshot.total_processes = processes.total;
+  snapshot.running_processes = processes.running;
+  LinuxParser::DiskStats(snapshot.disks);
+  LinuxParser::NetworkStats(snapshot.network);
+  return snapshot;
+}
+
+double SystemSnapshot::Seconds() const {
+  return clock_seconds;
+}
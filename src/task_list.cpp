@@ -0,0 +1,48 @@
+#include <algorithm>
+
+#include "linux_parser.h"
+#include "task_list.h"
+
+TaskList::TaskList(int pid) : pid_(pid) {}
+
+// utime + stime of every thread against the jiffies of the whole
+// system since the last refresh, as the CPU usage of a process
+void TaskList::Refresh(const SystemSnapshot& snapshot) {
+  LinuxParser::Tids(pid_, tids_);
+  float system_delta = float(snapshot.total_jiffies - prev_total_jiffies_);
+  bool first = prev_total_jiffies_ == 0;
+  prev_total_jiffies_ = snapshot.total_jiffies;
+
+  std::unordered_map<int, Previous> current;
+  current.reserve(tids_.size());
+  tasks_.clear();
+  ProcReader::PidStat stat;
+  for (int tid : tids_) {
+    if (!LinuxParser::ThreadStat(pid_, tid, stat)) {
+      continue;  // the thread exited since the listing
+    }
+    long jiffies = stat.utime + stat.stime;
+    Task task;
+    task.tid = tid;
+    task.name.assign(stat.comm.data(), stat.comm.size());
+    task.state = stat.state;
+    auto previous = previous_.find(tid);
+    if (!first && system_delta > 0 && previous != previous_.end() &&
+        previous->second.start_time == stat.starttime) {
+      task.cpu_utilization =
+          float(jiffies - previous->second.jiffies) / system_delta;
+    }
+    current[tid] = Previous{stat.starttime, jiffies};
+    tasks_.push_back(std::move(task));
+  }
+  previous_.swap(current);
+  std::sort(tasks_.begin(), tasks_.end(), [](const Task& a, const Task& b) {
+    return a.cpu_utilization != b.cpu_utilization
+               ? a.cpu_utilization > b.cpu_utilization
+               : a.tid < b.tid;
+  });
+}
+
+const std::vector<Task>& TaskList::Tasks() const {
+  return tasks_;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+
+#include "worker_pool.h"
+
+using std::size_t;
+
+WorkerPool::WorkerPool(unsigned int threads) {
+  // the calling thread is one of them
+  for (unsigned int i = 1; i < threads; ++i) {
+    threads_.emplace_back(&WorkerPool::Run, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+unsigned int WorkerPool::Threads() const {
+  return threads_.size() + 1;
+}
+
+void WorkerPool::ParallelFor(
+    size_t count, size_t chunk,
+    const std::function<void(size_t, size_t)>& work) {
+  chunk = std::max<size_t>(chunk, 1);
+  if (threads_.empty() || count <= chunk) {
+    for (size_t begin = 0; begin < count; begin += chunk) {
+      work(begin, std::min(begin + chunk, count));
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_ = &work;
+    count_ = count;
+    chunk_ = chunk;
+    next_ = 0;
+    busy_ = threads_.size();
+    counters_ = SelfStats::Counters();
+    ++round_;
+  }
+  start_.notify_all();
+  Drain();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return busy_ == 0; });
+  work_ = nullptr;
+  SelfStats::Credit(counters_);
+}
+
+void WorkerPool::Run() {
+  unsigned long seen_round = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock,
+                  [this, seen_round] { return stopping_ || round_ != seen_round; });
+      if (stopping_) {
+        return;
+      }
+      seen_round = round_;
+    }
+    SelfStats::Counters start = SelfStats::ThreadTotals();
+    Drain();
+    SelfStats::Counters end = SelfStats::ThreadTotals();
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters_.syscalls += end.syscalls - start.syscalls;
+    counters_.bytes_read += end.bytes_read - start.bytes_read;
+    counters_.allocations += end.allocations - start.allocations;
+    if (--busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void WorkerPool::Drain() {
+  size_t begin;
+  while ((begin = next_.fetch_add(chunk_)) < count_) {
+    (*work_)(begin, std::min(begin + chunk_, count_));
+  }
+}